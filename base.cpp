@@ -27,8 +27,11 @@
 
 #include "base.hpp"
 
-bool GenEx::Init() {
+bool GenEx::Init(bool headless) {
     bool flag = true;
+    if (headless)
+        SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+
     if (SDL_Init(SDL_INIT_EVERYTHING) < 0)
         return false;
 
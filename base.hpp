@@ -36,6 +36,7 @@
 #include <sstream>
 #include <iomanip>
 #include <vector>
+#include <list>
 #include <exception>
 #include <chrono>
 #include <algorithm>
@@ -45,8 +46,10 @@
 #include <unordered_map>
 #include <exception>
 #include <tuple>
+#include <typeinfo>
 #include <regex>
 #include <memory>
+#include <atomic>
 
 #define SDL_main main
 #include "SDL.h"
@@ -129,8 +132,13 @@ namespace GenEx {
 // -- INITIALIZE GENEX ----------------------------------------------------------------------------
 
     /** \brief Initializes the General Executor and SDL
+     *
+     * \param bool <u><i>headless</i></u>: TRUE to use SDL's dummy video driver so no display
+     *        is needed; only headless windows can be opened then; defaults to FALSE
+     * \return bool FALSE if SDL or one of its libraries failed to start
+     *
      */
-    bool Init();
+    bool Init(bool headless = false);
 
 // -- GENEX OBJECT FORWARD DECLARATION ------------------------------------------------------------
 
@@ -0,0 +1,207 @@
+/**
+ * \file components.cpp
+ *
+ * \author Simon Struthers <snstruthers@gmail.com>
+ * \version pre_dev v0.1.0
+ *
+ * \section LICENSE
+ * GenEx (short for General Executor) - window manager and runtime environment.
+ * Copyright (C) 2019 | The GenEx Project
+ *
+ * This file is part of GenEx.
+ *
+ * GenEx is free software: you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License version 2 as published by the Free Software Foundation.
+ *
+ * GenEx is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at https://www.gnu.org/copyleft/gpl.html
+ *
+ * You should have received a copy of the GNU General Public License version 2 along with GenEx.
+ * If not, see http://www.gnu.org/licenses.
+ *
+ * \section DESCRIPTION
+ * The source file for component stores that keep per-object state packed together.
+ *
+ */
+
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "components.hpp"
+#include "object.hpp"
+
+// --- TRANSFORM STORE ----------------------------------------------------------------------------
+
+namespace {
+    /* prev[i] = value[i]; value[i] += delta[i] * k */
+    void IntegrateArray(double *value, double *prev, const double *delta, size_t count,
+                        double k) {
+        size_t i = 0;
+#ifdef __SSE2__
+        __m128d vk = _mm_set1_pd(k);
+        for (; i + 2 <= count; i += 2) {
+            __m128d v = _mm_loadu_pd(value + i);
+            _mm_storeu_pd(prev + i, v);
+            _mm_storeu_pd(value + i, _mm_add_pd(v, _mm_mul_pd(_mm_loadu_pd(delta + i), vk)));
+        }
+#endif
+        for (; i < count; i++) {
+            prev[i] = value[i];
+            value[i] += delta[i] * k;
+        }
+    }
+}
+
+GenEx::TransformStore::~TransformStore() { clear(); }
+
+bool GenEx::TransformStore::add(GenEx::Object *object) {
+    if (object->transform_store != nullptr)
+        return false;
+
+    object->transform_store = this;
+    object->transform_row = owners.size();
+    owners.push_back(object);
+    for (int axis = 0; axis < 3; axis++) {
+        pos[axis].push_back(object->position[axis]);
+        prev_pos[axis].push_back(object->integrated ? object->prev_position[axis] :
+                                                      object->position[axis]);
+        rot[axis].push_back(object->rotation[axis]);
+        prev_rot[axis].push_back(object->integrated ? object->prev_rotation[axis] :
+                                                      object->rotation[axis]);
+        move[axis].push_back(object->move_vector[axis]);
+        angle[axis].push_back(object->angle_vector[axis]);
+    }
+    return true;
+}
+
+void GenEx::TransformStore::remove(GenEx::Object *object) {
+    if (object->transform_store != this)
+        return;
+
+    // hand the row back to the object
+    size_t row = object->transform_row;
+    object->position = { pos[0][row], pos[1][row], pos[2][row] };
+    object->prev_position = { prev_pos[0][row], prev_pos[1][row], prev_pos[2][row] };
+    object->rotation = { rot[0][row], rot[1][row], rot[2][row] };
+    object->prev_rotation = { prev_rot[0][row], prev_rot[1][row], prev_rot[2][row] };
+
+    size_t last = owners.size() - 1;
+    if (row != last) {
+        owners[row] = owners[last];
+        owners[row]->transform_row = row;
+        for (int axis = 0; axis < 3; axis++) {
+            pos[axis][row] = pos[axis][last];
+            prev_pos[axis][row] = prev_pos[axis][last];
+            rot[axis][row] = rot[axis][last];
+            prev_rot[axis][row] = prev_rot[axis][last];
+            move[axis][row] = move[axis][last];
+            angle[axis][row] = angle[axis][last];
+        }
+    }
+
+    owners.pop_back();
+    for (int axis = 0; axis < 3; axis++) {
+        pos[axis].pop_back();
+        prev_pos[axis].pop_back();
+        rot[axis].pop_back();
+        prev_rot[axis].pop_back();
+        move[axis].pop_back();
+        angle[axis].pop_back();
+    }
+    object->transform_store = nullptr;
+}
+
+void GenEx::TransformStore::clear() {
+    for (size_t row = 0; row < owners.size(); row++) {
+        GenEx::Object *object = owners[row];
+        object->position = { pos[0][row], pos[1][row], pos[2][row] };
+        object->prev_position = { prev_pos[0][row], prev_pos[1][row], prev_pos[2][row] };
+        object->rotation = { rot[0][row], rot[1][row], rot[2][row] };
+        object->prev_rotation = { prev_rot[0][row], prev_rot[1][row], prev_rot[2][row] };
+        object->transform_store = nullptr;
+    }
+    owners.clear();
+    for (int axis = 0; axis < 3; axis++) {
+        pos[axis].clear();
+        prev_pos[axis].clear();
+        rot[axis].clear();
+        prev_rot[axis].clear();
+        move[axis].clear();
+        angle[axis].clear();
+    }
+}
+
+void GenEx::TransformStore::gather(GenEx::Object *object) {
+    if (object->transform_store != this)
+        return;
+
+    size_t row = object->transform_row;
+    for (int axis = 0; axis < 3; axis++) {
+        pos[axis][row] = object->position[axis];
+        rot[axis][row] = object->rotation[axis];
+        move[axis][row] = object->move_vector[axis];
+        angle[axis][row] = object->angle_vector[axis];
+    }
+}
+
+void GenEx::TransformStore::integrate(double elapsed) {
+    step = 60.0 * elapsed; // vectors are per 1/60th of a second
+    size_t count = owners.size();
+    for (int axis = 0; axis < 3; axis++) {
+        IntegrateArray(pos[axis].data(), prev_pos[axis].data(), move[axis].data(), count, step);
+        IntegrateArray(rot[axis].data(), prev_rot[axis].data(), angle[axis].data(), count, step);
+    }
+}
+
+void GenEx::TransformStore::sync(size_t row) {
+    GenEx::Object *object = owners[row];
+    double *position = object->position.data(), *prev_position = object->prev_position.data();
+    double *rotation = object->rotation.data(), *prev_rotation = object->prev_rotation.data();
+    const double *move_vector = object->move_vector.data();
+    const double *angle_vector = object->angle_vector.data();
+
+    // integrate() left the last scattered values in prev_*, so anything that differs from
+    // them was written directly; redo this step from the written values
+    for (int axis = 0; axis < 3; axis++) {
+        if (position[axis] != prev_pos[axis][row] || move_vector[axis] != move[axis][row]) {
+            prev_pos[axis][row] = position[axis];
+            move[axis][row] = move_vector[axis];
+            pos[axis][row] = prev_pos[axis][row] + move[axis][row] * step;
+        }
+        if (rotation[axis] != prev_rot[axis][row] || angle_vector[axis] != angle[axis][row]) {
+            prev_rot[axis][row] = rotation[axis];
+            angle[axis][row] = angle_vector[axis];
+            rot[axis][row] = prev_rot[axis][row] + angle[axis][row] * step;
+        }
+
+        prev_position[axis] = prev_pos[axis][row];
+        prev_rotation[axis] = prev_rot[axis][row];
+        position[axis] = pos[axis][row];
+        rotation[axis] = rot[axis][row];
+    }
+    object->integrated = true;
+}
+
+void GenEx::TransformStore::scatter() {
+    for (size_t row = 0; row < owners.size(); row++) {
+#ifdef __SSE2__
+        // objects are big & spread over the heap; start pulling in the ones coming up
+        if (row + 8 < owners.size())
+            _mm_prefetch((const char*)&owners[row + 8]->position, _MM_HINT_T0);
+#endif
+        sync(row);
+    }
+}
+
+bool GenEx::TransformStore::scatter(GenEx::Object *object) {
+    if (object->transform_store != this)
+        return false;
+
+    sync(object->transform_row);
+    return true;
+}
+
+size_t GenEx::TransformStore::size() const { return owners.size(); }
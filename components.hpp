@@ -0,0 +1,142 @@
+/**
+ * \file components.hpp
+ *
+ * \author Simon Struthers <snstruthers@gmail.com>
+ * \version pre_dev v0.1.0
+ *
+ * \section LICENSE
+ * GenEx (short for General Executor) - window manager and runtime environment.
+ * Copyright (C) 2019 | The GenEx Project
+ *
+ * This file is part of GenEx.
+ *
+ * GenEx is free software: you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License version 2 as published by the Free Software Foundation.
+ *
+ * GenEx is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at https://www.gnu.org/copyleft/gpl.html
+ *
+ * You should have received a copy of the GNU General Public License version 2 along with GenEx.
+ * If not, see http://www.gnu.org/licenses.
+ *
+ * \section DESCRIPTION
+ * The header file for component stores that keep per-object state packed together.
+ *
+ */
+
+
+#ifndef COMPONENTS_HPP
+#define COMPONENTS_HPP
+
+#include "base.hpp"
+#include "math.hpp"
+
+namespace GenEx {
+    class Object;
+
+// --- TRANSFORM STORE ----------------------------------------------------------------------------
+
+    /** \brief Keeps the motion state of many objects in structure-of-arrays form so it can be
+     *        integrated with SIMD in one pass, letting a Layer skip update() for children that
+     *        have no update handler of their own.
+     *
+     * Each attached object owns a row. The objects stay the one source of truth: scatter()
+     * writes the new & previous position & rotation back into them, and render & hit-testing
+     * only ever read the objects. A position, rotation, move_vector or angle_vector written
+     * directly since the last scatter() is noticed there & wins over the row, so calling
+     * Object::commit_transform() is only needed to make such a write take effect sooner.
+     *
+     * The rows are only a layout for the SIMD integration, not a cache the rest of the engine
+     * reads: scatter() still visits every object once per update, so the arrays are a second
+     * copy of the state that is walked on top of the objects. On its own that is slower than
+     * plain per-object updates; it only pays off for code that reads or integrates the rows
+     * directly.
+     */
+    class TransformStore {
+    private:
+        // one array per component axis; index is the row
+        std::vector<double> pos[3], prev_pos[3];
+        std::vector<double> rot[3], prev_rot[3];
+        std::vector<double> move[3], angle[3];
+        std::vector<Object*> owners;
+
+        double step = 0.0; // how many 1/60ths of a second the last integrate() covered
+
+        /** \brief Folds direct writes to an object's members into its row & copies the row
+         *        back into the object.
+         *
+         * \param size_t <u>row</u>: The object's row
+         *
+         */
+        void sync(size_t row);
+
+    public:
+        TransformStore() = default;
+
+        TransformStore(const TransformStore &other) = delete;
+        TransformStore &operator= (const TransformStore &other) = delete;
+
+        /** \brief Detaches every object still in the store.
+         */
+        ~TransformStore();
+
+        /** \brief Attaches an object, copying its current transform into a new row. Objects
+         *        already in a store are left alone.
+         *
+         * \param Object *<u>object</u>: The object to attach
+         * \return bool FALSE if the object was already in a store
+         *
+         */
+        bool add(Object *object);
+
+        /** \brief Detaches an object. The last row moves into its place.
+         *
+         * \param Object *<u>object</u>: The object to detach; ignored if it's not in this store
+         *
+         */
+        void remove(Object *object);
+
+        /** \brief Detaches every object.
+         */
+        void clear();
+
+        /** \brief Copies an attached object's members into its row.
+         *
+         * \param Object *<u>object</u>: An object in this store
+         *
+         */
+        void gather(Object *object);
+
+        /** \brief Advances every row's position & rotation by its movement & rotation
+         *        vectors, remembering the old values for interpolation. Uses SSE2 when the
+         *        compiler targets it.
+         *
+         * \param double <u>elapsed</u>: Seconds since the last update
+         *
+         */
+        void integrate(double elapsed);
+
+        /** \brief Copies every row's position & rotation, new & previous, back into its
+         *        object.
+         */
+        void scatter();
+
+        /** \brief Copies one object's position & rotation, new & previous, back into it.
+         *
+         * \param Object *<u>object</u>: The object
+         * \return bool FALSE if the object isn't in this store
+         *
+         */
+        bool scatter(Object *object);
+
+        /** \brief Returns how many objects are attached.
+         *
+         * \return size_t Number of rows
+         *
+         */
+        size_t size() const;
+    };
+}
+
+#endif // COMPONENTS_HPP
@@ -26,6 +26,10 @@
  */
 
 #include "debug.hpp"
+#include "graphics.hpp"
+#include "math.hpp"
+#include "object.hpp"
+#include "time.hpp"
 
 std::string GenEx::Debug::GetVersionString() {
     std::stringstream sst;
@@ -416,3 +420,202 @@ std::string GenEx::Debug::GetEventString(SDL_Event &event) {
 }
 
 std::string GenEx::Debug::GetEventString(SDL_Event *event) { return GetEventString(*event); }
+
+// --- BENCHMARKS ---------------------------------------------------------------------------------
+
+namespace {
+    // RenderLine() before it had a rasterizer; kept to measure against
+    void LegacyRenderLine(SDL_Renderer *target, SDL_Color color, int x0, int y0, int x1,
+                          int y1) {
+        Uint8 r,g,b,a;
+        SDL_BlendMode blend_mode;
+        SDL_GetRenderDrawColor(target, &r, &g, &b, &a);
+        SDL_GetRenderDrawBlendMode(target, &blend_mode);
+
+        std::map<Uint8, std::vector<SDL_Point> > alpha_map;
+
+        bool steep = SDL_abs(y1-y0) > SDL_abs(x1-x0);
+        if (steep) {
+            std::swap(x0, y0);
+            std::swap(x1, y1);
+        }
+        if (x0 > x1) {
+            std::swap(x0, x1);
+            std::swap(y0, y1);
+        }
+
+        float dx = x1-x0;
+        float dy = y1-y0;
+        float gradient = dx == 0.0 ? 1 : dy/dx;
+        float intersectY = y0;
+        for (int x = x0; x <= x1; x++) {
+            int lo = (int)intersectY;
+            alpha_map[(Uint8)(255*freciprocal(intersectY))].emplace_back(
+                steep ? SDL_Point{ lo, x } : SDL_Point{ x, lo });
+            alpha_map[(Uint8)(255*fracofnum(intersectY))].emplace_back(
+                steep ? SDL_Point{ lo + 1, x } : SDL_Point{ x, lo + 1 });
+            intersectY += gradient;
+        }
+
+        SDL_SetRenderDrawBlendMode(target, SDL_BLENDMODE_BLEND);
+        for (auto &iter : alpha_map) {
+            if (iter.first > 0) {
+                SDL_SetRenderDrawColor(target, color.r, color.g, color.b,
+                                       (Uint8)(color.a*(iter.first / 255.f)));
+                SDL_RenderDrawPoints(target, &(iter.second)[0], iter.second.size());
+            }
+        }
+
+        SDL_SetRenderDrawColor(target, r, g, b, a);
+        SDL_SetRenderDrawBlendMode(target, blend_mode);
+    }
+}
+
+std::string GenEx::Debug::BenchmarkLayer(size_t count) {
+    std::stringstream sst;
+    sst << std::fixed << std::setprecision(2);
+
+    std::vector< std::shared_ptr<GenEx::Object> > children;
+    children.reserve(count);
+    for (size_t i = 0; i < count; i++)
+        children.push_back(std::make_shared<GenEx::Object>());
+
+    GenEx::Layer layer;
+    double t = GenEx::Time::GetTime();
+    for (size_t i = 0; i < count; i++)
+        layer.add_object(children[i], "object" + std::to_string(i));
+    sst << "add " << count << " children: " << (GenEx::Time::GetTime() - t) * 1000.0 << " ms\n";
+
+    t = GenEx::Time::GetTime();
+    size_t found = 0;
+    for (size_t i = 0; i < count; i++)
+        if (layer.get_object(layer.get_name(children[i]->get_id())) == children[i])
+            found++;
+    sst << "ID -> name -> object lookups: " << (GenEx::Time::GetTime() - t) * 1000.0 << " ms ("
+        << found << " found)\n";
+
+    t = GenEx::Time::GetTime();
+    GenEx::Object *copy = layer.clone();
+    sst << "clone: " << (GenEx::Time::GetTime() - t) * 1000.0 << " ms\n";
+    delete copy;
+
+    // a third each by ID, by name & by pointer
+    t = GenEx::Time::GetTime();
+    for (size_t i = 0; i < count; i++) {
+        switch (i % 3) {
+        case 0:
+            layer.remove_object(children[i]->get_id());
+            break;
+        case 1:
+            layer.remove_object("object" + std::to_string(i));
+            break;
+        default:
+            layer.remove_object(children[i]);
+            break;
+        }
+    }
+    sst << "remove " << count << " children: " << (GenEx::Time::GetTime() - t) * 1000.0
+        << " ms (" << layer.num_objects() << " left)\n";
+
+    // every name collides, so each add has to pick a fresh suffix
+    GenEx::Layer same_names;
+    t = GenEx::Time::GetTime();
+    std::string last;
+    for (size_t i = 0; i < count; i++)
+        last = same_names.add_object(children[i], "object");
+    sst << "add " << count << " children named \"object\": "
+        << (GenEx::Time::GetTime() - t) * 1000.0 << " ms (last: " << last << ")\n";
+
+    // mass despawn: kill every other child, then sweep them out together
+    std::vector<Uint64> doomed;
+    for (size_t i = 0; i < count; i += 2)
+        doomed.push_back(children[i]->get_id());
+    t = GenEx::Time::GetTime();
+    same_names.destroy_objects(doomed);
+    size_t swept = same_names.remove_dead();
+    sst << "destroy & sweep " << swept << " children: " << (GenEx::Time::GetTime() - t) * 1000.0
+        << " ms\n";
+
+    // a second of motion at 60 ticks per second, object by object & then in bulk
+    GenEx::Layer movers;
+    for (size_t i = 0; i < count; i++) {
+        std::shared_ptr<GenEx::Object> mover = std::make_shared<GenEx::Object>();
+        mover->move_vector = GenEx::Math::Vector3({ 1.0, 0.5, 0.0 });
+        movers.add_object(mover, "object" + std::to_string(i));
+    }
+    t = GenEx::Time::GetTime();
+    for (int step = 0; step < 60; step++)
+        movers.update(1.0 / 60.0);
+    sst << "60 updates of " << count << " children: " << (GenEx::Time::GetTime() - t) * 1000.0
+        << " ms\n";
+
+    movers.set_bulk_transforms(true);
+    t = GenEx::Time::GetTime();
+    for (int step = 0; step < 60; step++)
+        movers.update(1.0 / 60.0);
+    sst << "60 bulk updates of " << count << " children: "
+        << (GenEx::Time::GetTime() - t) * 1000.0 << " ms\n";
+
+    return sst.str();
+}
+
+std::string GenEx::Debug::BenchmarkLines(size_t count) {
+    std::stringstream sst;
+    sst << std::fixed << std::setprecision(2);
+
+    SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0, 1024, 768, 32,
+                                                          SDL_PIXELFORMAT_ARGB8888);
+    SDL_Renderer *renderer = surface ? SDL_CreateSoftwareRenderer(surface) : nullptr;
+    if (renderer == nullptr) {
+        if (surface)
+            SDL_FreeSurface(surface);
+        return "lines: couldn't create a software renderer\n";
+    }
+
+    // the same pseudo-random lines, up to 200 pixels long, for every run
+    struct Line { int x0, y0, x1, y1; };
+    std::vector<Line> lines(count);
+    Uint32 seed = 1;
+    auto next = [&seed](int range) {
+        seed = seed * 1664525u + 1013904223u;
+        return (int)((seed >> 8) % (Uint32)range);
+    };
+    for (auto &line : lines) {
+        line.x0 = next(1024);
+        line.y0 = next(768);
+        line.x1 = std::min(std::max(line.x0 + next(401) - 200, 0), 1023);
+        line.y1 = std::min(std::max(line.y0 + next(401) - 200, 0), 767);
+    }
+    SDL_Color color = { 255, 255, 255, 255 };
+
+    double t = GenEx::Time::GetTime();
+    for (auto &line : lines)
+        LegacyRenderLine(renderer, color, line.x0, line.y0, line.x1, line.y1);
+    sst << count << " lines, old per-point renderer: " << (GenEx::Time::GetTime() - t) * 1000.0
+        << " ms\n";
+
+    {
+        GenEx::Graphics::LineRasterizer raster(renderer);
+
+        t = GenEx::Time::GetTime();
+        for (auto &line : lines)
+            GenEx::Graphics::RenderLine(renderer, color, line.x0, line.y0, line.x1, line.y1, 1.f);
+        sst << count << " lines, rasterized one by one: " << (GenEx::Time::GetTime() - t) * 1000.0
+            << " ms\n";
+
+        for (float width : { 1.f, 4.f }) {
+            t = GenEx::Time::GetTime();
+            raster.begin();
+            for (auto &line : lines)
+                GenEx::Graphics::RenderLine(renderer, color, line.x0, line.y0, line.x1, line.y1,
+                                            width);
+            raster.end();
+            sst << count << " lines " << width << " px wide, rasterized in one upload: "
+                << (GenEx::Time::GetTime() - t) * 1000.0 << " ms\n";
+        }
+    }
+
+    SDL_DestroyRenderer(renderer);
+    SDL_FreeSurface(surface);
+    return sst.str();
+}
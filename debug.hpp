@@ -106,6 +106,28 @@ namespace GenEx {
          *
          */
          std::string GetEventString(SDL_Event *event);
+
+// --- BENCHMARKS ---------------------------------------------------------------------------------
+
+        /** \brief Times adding, looking up, cloning & removing a large number of children in a
+         *        Layer, then adding them all under the same name, despawning half of them &
+         *        moving them with & without bulk transforms.
+         *
+         * \param size_t <u><i>count</i></u>: How many children to use; defaults to 100000
+         * \return std::string Time taken by each step, one per line
+         *
+         */
+        std::string BenchmarkLayer(size_t count = 100000);
+
+        /** \brief Times drawing the same random lines onto a 1024x768 software renderer with
+         *        the old per-point line renderer, then with RenderLine() one upload per line,
+         *        then batched into one upload at 1 & 4 pixels wide.
+         *
+         * \param size_t <u><i>count</i></u>: How many lines to draw; defaults to 10000
+         * \return std::string Time taken by each run, one per line
+         *
+         */
+        std::string BenchmarkLines(size_t count = 10000);
     }
 }
 
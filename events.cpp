@@ -67,3 +67,127 @@ GenEx::Events::EventHandlers GenEx::Events::GenerateEventHandlerStruct() {
 
     return evt_handlers;
 }
+
+GenEx::Events::EventMask GenEx::Events::GetEventMask(
+        const GenEx::Events::EventHandlers &evt_handlers) {
+    GenEx::Events::EventMask mask = GenEx::Events::MASK_NONE;
+
+    if (evt_handlers.windowevent != GenEx::Events::WindowEventHandler)
+        mask |= GenEx::Events::MASK_WINDOWEVENT;
+    if (evt_handlers.targetreset != GenEx::Events::TargetResetEventHandler)
+        mask |= GenEx::Events::MASK_TARGETRESET;
+    if (evt_handlers.keydown != GenEx::Events::KeyDownEventHandler)
+        mask |= GenEx::Events::MASK_KEYDOWN;
+    if (evt_handlers.keyup != GenEx::Events::KeyUpEventHandler)
+        mask |= GenEx::Events::MASK_KEYUP;
+    if (evt_handlers.textediting != GenEx::Events::TextEditingEventHandler)
+        mask |= GenEx::Events::MASK_TEXTEDITING;
+    if (evt_handlers.textinput != GenEx::Events::TextInputEventHandler)
+        mask |= GenEx::Events::MASK_TEXTINPUT;
+    if (evt_handlers.mousedown != GenEx::Events::MouseButtonDownEventHandler)
+        mask |= GenEx::Events::MASK_MOUSEDOWN;
+    if (evt_handlers.mouseup != GenEx::Events::MouseButtonUpEventHandler)
+        mask |= GenEx::Events::MASK_MOUSEUP;
+    if (evt_handlers.mousemotion != GenEx::Events::MouseMotionEventHandler)
+        mask |= GenEx::Events::MASK_MOUSEMOTION;
+    if (evt_handlers.mousewheel != GenEx::Events::MouseWheelEventHandler)
+        mask |= GenEx::Events::MASK_MOUSEWHEEL;
+    if (evt_handlers.clipboardupdate != GenEx::Events::ClipboardUpdateEventHandler)
+        mask |= GenEx::Events::MASK_CLIPBOARDUPDATE;
+    if (evt_handlers.filedrop != GenEx::Events::DropFileEventHandler)
+        mask |= GenEx::Events::MASK_FILEDROP;
+    if (evt_handlers.textdrop != GenEx::Events::DropTextEventHandler)
+        mask |= GenEx::Events::MASK_TEXTDROP;
+    if (evt_handlers.begindrop != GenEx::Events::DropBeginEventHandler)
+        mask |= GenEx::Events::MASK_BEGINDROP;
+    if (evt_handlers.completedrop != GenEx::Events::DropCompleteEventHandler)
+        mask |= GenEx::Events::MASK_COMPLETEDROP;
+    if (evt_handlers.jaxis != GenEx::Events::JoystickAxisEventHandler)
+        mask |= GenEx::Events::MASK_JAXIS;
+    if (evt_handlers.jball != GenEx::Events::JoystickTrackballEventHandler)
+        mask |= GenEx::Events::MASK_JBALL;
+    if (evt_handlers.jhat != GenEx::Events::JoystickHatEventHandler)
+        mask |= GenEx::Events::MASK_JHAT;
+    if (evt_handlers.jbtndown != GenEx::Events::JoystickButtonDownEventHandler)
+        mask |= GenEx::Events::MASK_JBTNDOWN;
+    if (evt_handlers.jbtnup != GenEx::Events::JoystickButtonUpEventHandler)
+        mask |= GenEx::Events::MASK_JBTNUP;
+    if (evt_handlers.caxis != GenEx::Events::ControllerAxisEventHandler)
+        mask |= GenEx::Events::MASK_CAXIS;
+    if (evt_handlers.cbtndown != GenEx::Events::ControllerButtonDownEventHandler)
+        mask |= GenEx::Events::MASK_CBTNDOWN;
+    if (evt_handlers.cbtnup != GenEx::Events::ControllerButtonUpEventHandler)
+        mask |= GenEx::Events::MASK_CBTNUP;
+    if (evt_handlers.fingerdown != GenEx::Events::FingerDownEventHandler)
+        mask |= GenEx::Events::MASK_FINGERDOWN;
+    if (evt_handlers.fingerup != GenEx::Events::FingerUpEventHandler)
+        mask |= GenEx::Events::MASK_FINGERUP;
+    if (evt_handlers.fingermotion != GenEx::Events::FingerMotionEventHandler)
+        mask |= GenEx::Events::MASK_FINGERMOTION;
+    if (evt_handlers.gesturerecord != GenEx::Events::RecordGestureEventHandler)
+        mask |= GenEx::Events::MASK_GESTURERECORD;
+    if (evt_handlers.gestureperform != GenEx::Events::PerformGestureEventHandler)
+        mask |= GenEx::Events::MASK_GESTUREPERFORM;
+    if (evt_handlers.multigesture != GenEx::Events::MultiGestureEventHandler)
+        mask |= GenEx::Events::MASK_MULTIGESTURE;
+    if (evt_handlers.userevent != GenEx::Events::UserEventHandler)
+        mask |= GenEx::Events::MASK_USEREVENT;
+    if (evt_handlers.update != GenEx::Events::UpdateEventHandler)
+        mask |= GenEx::Events::MASK_UPDATE;
+
+    return mask;
+}
+
+// --- INTERNED HANDLER TABLES --------------------------------------------------------------------
+
+namespace {
+    // EventHandlers is nothing but function pointers, so there's no padding to trip up
+    // hashing & comparing it byte by byte
+    size_t HashEventHandlers(const GenEx::Events::EventHandlers &evt_handlers) {
+        const unsigned char *bytes = (const unsigned char*)&evt_handlers;
+        size_t hash = 14695981039346656037ULL;
+        for (size_t i = 0; i < sizeof(evt_handlers); i++)
+            hash = (hash ^ bytes[i]) * 1099511628211ULL;
+        return hash;
+    }
+
+    std::unordered_multimap<size_t, const GenEx::Events::HandlerTable*> handler_tables;
+    SDL_SpinLock handler_tables_lock = 0;
+
+    // most objects are created in runs sharing the same handlers
+    thread_local const GenEx::Events::HandlerTable *last_interned = nullptr;
+}
+
+const GenEx::Events::HandlerTable *GenEx::Events::InternEventHandlers(
+        const GenEx::Events::EventHandlers &evt_handlers) {
+    if (last_interned != nullptr &&
+            SDL_memcmp(&last_interned->handlers, &evt_handlers, sizeof(evt_handlers)) == 0)
+        return last_interned;
+
+    size_t hash = HashEventHandlers(evt_handlers);
+    const GenEx::Events::HandlerTable *table = nullptr;
+
+    SDL_AtomicLock(&handler_tables_lock);
+    auto range = handler_tables.equal_range(hash);
+    for (auto it = range.first; it != range.second; it++) {
+        if (SDL_memcmp(&it->second->handlers, &evt_handlers, sizeof(evt_handlers)) == 0) {
+            table = it->second;
+            break;
+        }
+    }
+    if (table == nullptr) {
+        table = new GenEx::Events::HandlerTable{ evt_handlers,
+                                                 GenEx::Events::GetEventMask(evt_handlers) };
+        handler_tables.insert(std::make_pair(hash, table));
+    }
+    SDL_AtomicUnlock(&handler_tables_lock);
+
+    last_interned = table;
+    return table;
+}
+
+const GenEx::Events::HandlerTable *GenEx::Events::GetDefaultHandlerTable() {
+    static const GenEx::Events::HandlerTable *table =
+        GenEx::Events::InternEventHandlers(GenEx::Events::GenerateEventHandlerStruct());
+    return table;
+}
@@ -982,6 +982,105 @@ namespace GenEx {
          *
          */
         EventHandlers GenerateEventHandlerStruct();
+
+// --- EVENT SUBSCRIPTION MASKS -------------------------------------------------------------------
+
+        /** \brief Bitmask of the event kinds an object handles. Render, init & destroy handlers
+         *        always run and so have no bits. Update handlers always run too, except on
+         *        children a Layer moves in bulk; see <i>MASK_UPDATE</i>.
+         */
+        typedef Uint32 EventMask;
+
+        const EventMask MASK_WINDOWEVENT     = 1u << 0;
+        const EventMask MASK_TARGETRESET     = 1u << 1;
+        const EventMask MASK_KEYDOWN         = 1u << 2;
+        const EventMask MASK_KEYUP           = 1u << 3;
+        const EventMask MASK_TEXTEDITING     = 1u << 4;
+        const EventMask MASK_TEXTINPUT       = 1u << 5;
+        const EventMask MASK_MOUSEDOWN       = 1u << 6;
+        const EventMask MASK_MOUSEUP         = 1u << 7;
+        const EventMask MASK_MOUSEMOTION     = 1u << 8;
+        const EventMask MASK_MOUSEWHEEL      = 1u << 9;
+        const EventMask MASK_CLIPBOARDUPDATE = 1u << 10;
+        const EventMask MASK_FILEDROP        = 1u << 11;
+        const EventMask MASK_TEXTDROP        = 1u << 12;
+        const EventMask MASK_BEGINDROP       = 1u << 13;
+        const EventMask MASK_COMPLETEDROP    = 1u << 14;
+        const EventMask MASK_JAXIS           = 1u << 15;
+        const EventMask MASK_JBALL           = 1u << 16;
+        const EventMask MASK_JHAT            = 1u << 17;
+        const EventMask MASK_JBTNDOWN        = 1u << 18;
+        const EventMask MASK_JBTNUP          = 1u << 19;
+        const EventMask MASK_CAXIS           = 1u << 20;
+        const EventMask MASK_CBTNDOWN        = 1u << 21;
+        const EventMask MASK_CBTNUP          = 1u << 22;
+        const EventMask MASK_FINGERDOWN      = 1u << 23;
+        const EventMask MASK_FINGERUP        = 1u << 24;
+        const EventMask MASK_FINGERMOTION    = 1u << 25;
+        const EventMask MASK_GESTURERECORD   = 1u << 26;
+        const EventMask MASK_GESTUREPERFORM  = 1u << 27;
+        const EventMask MASK_MULTIGESTURE    = 1u << 28;
+        const EventMask MASK_USEREVENT       = 1u << 29;
+        const EventMask MASK_UPDATE          = 1u << 30; // only checked by bulk-transform Layers
+
+        const EventMask MASK_NONE = 0;
+        const EventMask MASK_ALL  = (1u << 31) - 1;
+
+        /** \brief Works out which event kinds a set of handlers actually handles, i.e. which
+         *        handlers were changed from the defaults in GenerateEventHandlerStruct().
+         *
+         * \param EventHandlers &<u>evt_handlers</u>: The event handlers to check
+         * \return EventMask Bits set for every non-default handler
+         *
+         */
+        EventMask GetEventMask(const EventHandlers &evt_handlers);
+
+// --- INTERNED HANDLER TABLES --------------------------------------------------------------------
+
+        /** \brief An immutable set of event handlers. Equal sets are interned into one table that
+         *        every object using them points at; tables are never freed.
+         */
+        struct HandlerTable {
+            EventHandlers handlers;
+            EventMask mask; // GetEventMask(handlers), worked out once
+        };
+
+        /** \brief Gets the shared table holding a set of event handlers, creating it if this
+         *        set hasn't been seen before. Thread safe.
+         *
+         * \param EventHandlers &<u>evt_handlers</u>: The event handlers to look up
+         * \return HandlerTable* The interned table
+         *
+         */
+        const HandlerTable *InternEventHandlers(const EventHandlers &evt_handlers);
+
+        /** \brief Gets the interned table of the default event handlers.
+         *
+         * \return HandlerTable* The table for GenerateEventHandlerStruct()
+         *
+         */
+        const HandlerTable *GetDefaultHandlerTable();
+
+        /** \brief Gets the interned table equal to an existing one with a single handler
+         *        swapped out. The existing table is left untouched.
+         *
+         * \param HandlerTable *<u>table</u>: The table to start from
+         * \param F EventHandlers::*<u>member</u>: The handler to replace, e.g.
+         *        <i>&EventHandlers::keydown</i>
+         * \param F <u>handler</u>: The new handler
+         * \return HandlerTable* The interned table
+         *
+         */
+        template <typename F>
+        const HandlerTable *ReplaceEventHandler(const HandlerTable *table,
+                                                F EventHandlers::*member, F handler) {
+            if (table->handlers.*member == handler)
+                return table;
+
+            EventHandlers evt_handlers = table->handlers;
+            evt_handlers.*member = handler;
+            return InternEventHandlers(evt_handlers);
+        }
     }
 }
 
@@ -27,9 +27,13 @@
 
 #include "base.hpp"     // The base header; imports SDL & C++ std libs; defines general purpose vars
 #include "time.hpp"     // General-purpose timing functions & timer class
+#include "thread.hpp"   // Threading primitives
 #include "util.hpp"     // General-purpose utility functions
 #include "math.hpp"     // Math library
 #include "debug.hpp"    // Debugging-related string printout functions
 #include "events.hpp"   // Default event handlers
 #include "object.hpp"   // Base object implementation
+#include "components.hpp" // Packed per-object state (bulk transforms)
+#include "staticobject.hpp" // Objects with compile-time event handlers
 #include "graphics.hpp" // Graphics display library & primitives
+#include "record.hpp"   // Event recording & replay
@@ -25,18 +25,59 @@
  *
  */
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "graphics.hpp"
 
 // --- RENDERING FUNCTIONS ------------------------------------------------------------------------
 
+namespace {
+    // tile renderers only draw into their window's surface, never into target textures
+    GenEx::Graphics::TileRenderer *GetTileRenderer(SDL_Renderer *renderer) {
+        GenEx::Graphics::TileRenderer *tiles = GenEx::Graphics::TileRenderer::Get(renderer);
+        return tiles != nullptr && SDL_GetRenderTarget(renderer) == nullptr ? tiles : nullptr;
+    }
+
+    // lines held back by LineRasterizer::begin() were drawn before whatever comes next
+    void FlushLines(SDL_Renderer *renderer) {
+        GenEx::Graphics::LineRasterizer *raster = GenEx::Graphics::LineRasterizer::Get(renderer);
+        if (raster != nullptr)
+            raster->flush();
+    }
+
+    // what a line through [min, max] can touch: a square cap's corners reach past an end by
+    // the half width times root 2, plus a pixel of antialiasing
+    SDL_Rect LineBounds(float min_x, float min_y, float max_x, float max_y, float wd) {
+        int pad = (int)std::ceil(std::max(wd, 1.f)) + 2;
+        int left = (int)std::floor(min_x) - pad, top = (int)std::floor(min_y) - pad;
+        return SDL_Rect{ left, top, (int)std::ceil(max_x) + pad - left,
+                         (int)std::ceil(max_y) + pad - top };
+    }
+}
+
 bool GenEx::Graphics::RenderImg(SDL_Texture *img, SDL_Renderer *target, float x, float y,
                                 SDL_Rect *clipping_rect, float offset_x, float offset_y,
                                 float anchor_x, float anchor_y, double rotation, float scale_x,
                                 float scale_y, bool flip_horizontal, bool flip_vertical) {
     if (img == nullptr || target == nullptr) return false;
 
-    int tw, th; // get width & height
-    SDL_QueryTexture(img, nullptr, nullptr, &tw, &th);
+    FlushLines(target);
+    GenEx::Graphics::SpriteBatch *batch = GenEx::Graphics::SpriteBatch::GetActive(target);
+
+    int tw, th; // get width & height; a clipped image is only as big as its clip
+    if (clipping_rect != nullptr) {
+        tw = clipping_rect->w;
+        th = clipping_rect->h;
+    }
+    else if (batch != nullptr) {
+        SDL_Point size = batch->get_size(img);
+        tw = size.x;
+        th = size.y;
+    }
+    else
+        SDL_QueryTexture(img, nullptr, nullptr, &tw, &th);
 
     float w, h;
     w = scale_x * tw;
@@ -61,151 +102,1729 @@ bool GenEx::Graphics::RenderImg(SDL_Texture *img, SDL_Renderer *target, float x,
         flip = SDL_FLIP_VERTICAL;
     }
 
-    return SDL_RenderCopyEx(target, img, clipping_rect, &dstrect,
-                            rotation, nullptr, flip) == 0;
+    if (batch != nullptr) {
+        // take the texture's modulation now; the caller may change it before the flush
+        GenEx::Graphics::Sprite sprite;
+        sprite.texture = img;
+        sprite.has_src = clipping_rect != nullptr;
+        if (sprite.has_src)
+            sprite.src = *clipping_rect;
+        sprite.dst = dstrect;
+        sprite.rotation = rotation;
+        sprite.flip = flip;
+        SDL_GetTextureColorMod(img, &sprite.color.r, &sprite.color.g, &sprite.color.b);
+        SDL_GetTextureAlphaMod(img, &sprite.color.a);
+        SDL_GetTextureBlendMode(img, &sprite.blend);
+        batch->draw(sprite);
+        return true;
+    }
+
+    GenEx::Graphics::TileRenderer *tiles = GetTileRenderer(target);
+    if (tiles != nullptr)
+        tiles->flush();
+    return SDL_RenderCopyEx(target, img, clipping_rect, &dstrect,
+                            rotation, nullptr, flip) == 0;
+}
+
+bool GenEx::Graphics::RenderImg(SDL_Surface *surf, SDL_Renderer *target, float x, float y,
+                                SDL_Rect *clipping_rect, float offset_x, float offset_y,
+                                float anchor_x, float anchor_y, double rotation, float scale_x,
+                                float scale_y, bool flip_horizontal, bool flip_vertical) {
+    GenEx::Graphics::TextureCache *cache = GenEx::Graphics::TextureCache::Get(target);
+    if (cache != nullptr && surf != nullptr) {
+        SDL_Texture *tex = cache->get(surf);
+        if (tex == nullptr)
+            return false;
+        return GenEx::Graphics::RenderImg(tex, target, x, y, clipping_rect, offset_x, offset_y,
+                                          anchor_x, anchor_y, rotation, scale_x, scale_y,
+                                          flip_horizontal, flip_vertical);
+    }
+
+    // no cache for this renderer; make a throwaway texture
+    SDL_Texture *tex = SDL_CreateTextureFromSurface(target, surf);
+    if (tex == nullptr) {
+        return false;
+    }
+    bool ret_val = GenEx::Graphics::RenderImg(tex, target, x, y, clipping_rect, offset_x, offset_y,
+                                              anchor_x, anchor_y, rotation, scale_x, scale_y,
+                                              flip_horizontal, flip_vertical);
+
+    // the texture is about to go; draw it now if it was queued
+    GenEx::Graphics::SpriteBatch *batch = GenEx::Graphics::SpriteBatch::GetActive(target);
+    if (batch != nullptr)
+        batch->flush();
+    SDL_DestroyTexture(tex);
+    return ret_val;
+}
+
+void GenEx::Graphics::FlushRenderer(SDL_Renderer *target) {
+    if (target == nullptr)
+        return;
+
+    // the rasterizer draws queued sprites before its lines
+    GenEx::Graphics::LineRasterizer *raster = GenEx::Graphics::LineRasterizer::Get(target);
+    GenEx::Graphics::SpriteBatch *batch = GenEx::Graphics::SpriteBatch::GetActive(target);
+    if (raster != nullptr)
+        raster->flush();
+    if (batch != nullptr)
+        batch->flush();
+
+    GenEx::Graphics::TileRenderer *tiles = GetTileRenderer(target);
+    if (tiles != nullptr)
+        tiles->flush();
+}
+
+void GenEx::Graphics::RenderLine(SDL_Renderer *target, SDL_Color color,
+                                 int x0, int y0, int x1, int y1, float wd,
+                                 GenEx::Graphics::LineCap cap) {
+    GenEx::Graphics::LineRasterizer *raster = GenEx::Graphics::LineRasterizer::Get(target);
+    if (raster != nullptr) {
+        raster->line(x0 + 0.5f, y0 + 0.5f, x1 + 0.5f, y1 + 0.5f, wd, color, cap);
+        return;
+    }
+
+    // no rasterizer for this renderer; make one just big enough for this line
+    GenEx::Graphics::LineRasterizer temporary(target, LineBounds(
+        std::min(x0, x1), std::min(y0, y1), std::max(x0, x1) + 1, std::max(y0, y1) + 1, wd));
+    temporary.line(x0 + 0.5f, y0 + 0.5f, x1 + 0.5f, y1 + 0.5f, wd, color, cap);
+}
+
+void GenEx::Graphics::RenderFillRect(SDL_Renderer *target, SDL_Rect rect, SDL_Color color) {
+    FlushLines(target);
+    GenEx::Graphics::SpriteBatch *batch = GenEx::Graphics::SpriteBatch::GetActive(target);
+    if (batch != nullptr)
+        batch->flush();
+
+    GenEx::Graphics::TileRenderer *tiles = GetTileRenderer(target);
+    if (tiles != nullptr) {
+        tiles->fill_rect(rect, color);
+        return;
+    }
+
+    // leave the draw state as the caller set it
+    Uint8 r, g, b, a;
+    SDL_BlendMode blend;
+    SDL_GetRenderDrawColor(target, &r, &g, &b, &a);
+    SDL_GetRenderDrawBlendMode(target, &blend);
+    SDL_SetRenderDrawColor(target, color.r, color.g, color.b, color.a);
+    SDL_SetRenderDrawBlendMode(target, SDL_BLENDMODE_BLEND);
+    SDL_RenderFillRect(target, &rect);
+    SDL_SetRenderDrawColor(target, r, g, b, a);
+    SDL_SetRenderDrawBlendMode(target, blend);
+}
+
+template <typename T>
+void GenEx::Graphics::RenderLines(SDL_Renderer *target, SDL_Color color,
+                                  std::vector< Math::Vector<2,T> > &pts, float wd) {
+    if (pts.size() < 2)
+        return;
+
+    // one path, so the segments join instead of overlapping
+    std::unique_ptr<GenEx::Graphics::LineRasterizer> temporary;
+    GenEx::Graphics::LineRasterizer *raster = GenEx::Graphics::LineRasterizer::Get(target);
+    if (raster == nullptr) {
+        float min_x = (float)pts[0][0], min_y = (float)pts[0][1];
+        float max_x = min_x, max_y = min_y;
+        for (auto &pt : pts) {
+            min_x = std::min(min_x, (float)pt[0]);
+            min_y = std::min(min_y, (float)pt[1]);
+            max_x = std::max(max_x, (float)pt[0]);
+            max_y = std::max(max_y, (float)pt[1]);
+        }
+        temporary.reset(new GenEx::Graphics::LineRasterizer(target,
+            LineBounds(min_x, min_y, max_x + 1.f, max_y + 1.f, wd)));
+        raster = temporary.get();
+    }
+
+    raster->begin_path(wd, color, GenEx::Graphics::CAP_ROUND, GenEx::Graphics::JOIN_ROUND);
+    for (auto &pt : pts)
+        raster->line_to((float)pt[0] + 0.5f, (float)pt[1] + 0.5f);
+    raster->end_path();
+}
+
+template <typename T>
+void GenEx::Graphics::RenderBezier(GenEx::Math::Bezier<T> bezier, SDL_Renderer *target,
+                                   SDL_Color color, float thickness, unsigned int samples) {
+    std::vector< Math::Vector<2,T> > pts;
+    bezier.sample(pts, samples);
+
+    GenEx::Graphics::RenderLines(target, color, pts, thickness);
+}
+
+template <typename T>
+void GenEx::Graphics::RenderPath(GenEx::Math::Path<T> &path, SDL_Renderer *target,
+                                 SDL_Color color, float thickness) {
+    std::vector< Math::Vector<2,T> > pts;
+    path.sample(pts);
+
+    GenEx::Graphics::RenderLines(target, color, pts, thickness);
+}
+
+// --- SPRITE BATCH CLASS -------------------------------------------------------------------------
+
+thread_local GenEx::Graphics::SpriteBatch *GenEx::Graphics::SpriteBatch::current = nullptr;
+
+namespace {
+    const size_t NO_SPRITE = ~(size_t)0;
+
+    SDL_Rect SpriteBounds(const GenEx::Graphics::Sprite &sprite) {
+        if (sprite.rotation == 0.0)
+            return sprite.dst;
+
+        // any rotation about the centre stays inside the circle through the corners
+        int r = (int)std::ceil(std::sqrt((double)sprite.dst.w * sprite.dst.w +
+                                         (double)sprite.dst.h * sprite.dst.h) / 2.0);
+        int cx = sprite.dst.x + sprite.dst.w / 2, cy = sprite.dst.y + sprite.dst.h / 2;
+        return SDL_Rect{ cx - r - 1, cy - r - 1, 2 * r + 2, 2 * r + 2 };
+    }
+}
+
+GenEx::Graphics::SpriteBatch::SpriteBatch(SDL_Renderer *renderer) : renderer(renderer) { }
+
+GenEx::Graphics::SpriteBatch::~SpriteBatch() {
+    if (active)
+        current = previous;
+}
+
+GenEx::Graphics::SpriteBatch *GenEx::Graphics::SpriteBatch::GetActive(SDL_Renderer *renderer) {
+    return (current != nullptr && current->renderer == renderer) ? current : nullptr;
+}
+
+void GenEx::Graphics::SpriteBatch::begin() {
+    if (active)
+        return;
+    previous = current;
+    current = this;
+    active = true;
+    target = SDL_GetRenderTarget(renderer);
+}
+
+void GenEx::Graphics::SpriteBatch::end() {
+    if (!active)
+        return;
+    flush();
+    current = previous;
+    previous = nullptr;
+    active = false;
+    sizes.clear();
+}
+
+bool GenEx::Graphics::SpriteBatch::is_active() { return active; }
+
+void GenEx::Graphics::SpriteBatch::set_layer(int layer) { this->layer = layer; }
+
+SDL_Point GenEx::Graphics::SpriteBatch::get_size(SDL_Texture *texture) {
+    auto iter = sizes.find(texture);
+    if (iter != sizes.end())
+        return iter->second;
+
+    SDL_Point size = { 0, 0 };
+    SDL_QueryTexture(texture, nullptr, nullptr, &size.x, &size.y);
+    sizes[texture] = size;
+    return size;
+}
+
+void GenEx::Graphics::SpriteBatch::draw(GenEx::Graphics::Sprite sprite) {
+    // sprites queued for one render target must be drawn before switching to another
+    SDL_Texture *now = SDL_GetRenderTarget(renderer);
+    if (now != target) {
+        flush();
+        target = now;
+    }
+
+    sprite.layer = layer;
+    sprites.push_back(sprite);
+}
+
+bool GenEx::Graphics::SpriteBatch::overlaps(const Run &run, const SDL_Rect &bounds) {
+    // the union is only a first guess; runs interleaved with others cover a lot of gaps
+    size_t checked = 0;
+    for (size_t i = run.first; i != NO_SPRITE; i = next[i]) {
+        if (++checked > BATCH_LOOKBACK)
+            return true; // not worth the time; assume the worst
+        if (SDL_HasIntersection(&boxes[i], &bounds))
+            return true;
+    }
+    return false;
+}
+
+void GenEx::Graphics::SpriteBatch::build_runs(size_t begin, size_t end) {
+    size_t first_run = runs.size(); // runs of lower layers are off limits
+
+    for (size_t k = begin; k < end; k++) {
+        size_t index = order[k];
+        const GenEx::Graphics::Sprite &sprite = sprites[index];
+        SDL_Rect bounds = SpriteBounds(sprite);
+        boxes[index] = bounds;
+        next[index] = NO_SPRITE;
+
+        // walk back to the newest run we can join without jumping over anything we overlap
+        size_t stop = std::max(first_run, runs.size() > BATCH_LOOKBACK ?
+                                          runs.size() - BATCH_LOOKBACK : (size_t)0);
+        size_t found = NO_SPRITE;
+        for (size_t r = runs.size(); r-- > stop;) {
+            Run &run = runs[r];
+            if (run.texture == sprite.texture && run.blend == sprite.blend) {
+                found = r;
+                break;
+            }
+            if (SDL_HasIntersection(&run.bounds, &bounds) && overlaps(run, bounds))
+                break;
+        }
+
+        if (found == NO_SPRITE)
+            runs.push_back(Run{ sprite.texture, sprite.blend, bounds, index, index });
+        else {
+            Run &run = runs[found];
+            next[run.last] = index;
+            run.last = index;
+            SDL_UnionRect(&run.bounds, &bounds, &run.bounds);
+        }
+    }
+}
+
+void GenEx::Graphics::SpriteBatch::submit_runs() {
+    GenEx::Graphics::TileRenderer *tiles = GetTileRenderer(renderer);
+    for (const Run &run : runs) {
+        SDL_Texture *texture = run.texture;
+
+        if (tiles != nullptr) {
+            if (tiles->draw_sprite(sprites[run.first])) {
+                for (size_t i = next[run.first]; i != NO_SPRITE; i = next[i])
+                    tiles->draw_sprite(sprites[i]);
+                continue;
+            }
+            // SDL draws this run, so everything queued before it has to be down first
+            tiles->flush();
+        }
+
+        // leave the texture as the caller set it once the run is done
+        SDL_Color saved;
+        SDL_BlendMode saved_blend;
+        SDL_GetTextureColorMod(texture, &saved.r, &saved.g, &saved.b);
+        SDL_GetTextureAlphaMod(texture, &saved.a);
+        SDL_GetTextureBlendMode(texture, &saved_blend);
+
+        if (saved_blend != run.blend)
+            SDL_SetTextureBlendMode(texture, run.blend);
+
+        SDL_Color color = saved;
+        for (size_t i = run.first; i != NO_SPRITE; i = next[i]) {
+            const GenEx::Graphics::Sprite &sprite = sprites[i];
+            if (sprite.color.r != color.r || sprite.color.g != color.g ||
+                    sprite.color.b != color.b)
+                SDL_SetTextureColorMod(texture, sprite.color.r, sprite.color.g, sprite.color.b);
+            if (sprite.color.a != color.a)
+                SDL_SetTextureAlphaMod(texture, sprite.color.a);
+            color = sprite.color;
+
+            SDL_RenderCopyEx(renderer, texture, sprite.has_src ? &sprite.src : nullptr,
+                             &sprite.dst, sprite.rotation, nullptr, sprite.flip);
+        }
+
+        if (color.r != saved.r || color.g != saved.g || color.b != saved.b)
+            SDL_SetTextureColorMod(texture, saved.r, saved.g, saved.b);
+        if (color.a != saved.a)
+            SDL_SetTextureAlphaMod(texture, saved.a);
+        if (saved_blend != run.blend)
+            SDL_SetTextureBlendMode(texture, saved_blend);
+    }
+}
+
+void GenEx::Graphics::SpriteBatch::flush() {
+    run_count = 0;
+    if (sprites.empty())
+        return;
+
+    order.resize(sprites.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        return sprites[a].layer < sprites[b].layer;
+    });
+
+    runs.clear();
+    next.resize(sprites.size());
+    boxes.resize(sprites.size());
+    size_t begin = 0;
+    for (size_t k = 1; k <= order.size(); k++) {
+        if (k == order.size() || sprites[order[k]].layer != sprites[order[begin]].layer) {
+            build_runs(begin, k);
+            begin = k;
+        }
+    }
+
+    SDL_Texture *restore = SDL_GetRenderTarget(renderer);
+    if (restore != target)
+        SDL_SetRenderTarget(renderer, target);
+    submit_runs();
+    if (restore != target)
+        SDL_SetRenderTarget(renderer, restore);
+
+    run_count = runs.size();
+    sprites.clear();
+}
+
+size_t GenEx::Graphics::SpriteBatch::size() { return sprites.size(); }
+
+size_t GenEx::Graphics::SpriteBatch::get_run_count() { return run_count; }
+
+// --- SKYLINE PACKER -----------------------------------------------------------------------------
+
+GenEx::Graphics::SkylinePacker::SkylinePacker(int width, int height) : width(width),
+                                                                       height(height) {
+    clear();
+}
+
+void GenEx::Graphics::SkylinePacker::clear() {
+    skyline.clear();
+    skyline.push_back(Segment{ 0, 0, width });
+}
+
+bool GenEx::Graphics::SkylinePacker::fit(size_t index, int w, int h, int &y) {
+    if (skyline[index].x + w > width)
+        return false;
+
+    // rest on the highest segment underneath
+    y = 0;
+    for (int left = w; left > 0; index++) {
+        if (index >= skyline.size())
+            return false;
+        y = std::max(y, skyline[index].y);
+        if (y + h > height)
+            return false;
+        left -= skyline[index].w;
+    }
+    return true;
+}
+
+bool GenEx::Graphics::SkylinePacker::insert(int w, int h, bool allow_rotate, SDL_Rect &out,
+                                            bool &rotated) {
+    size_t best_index = 0;
+    int best_bottom = std::numeric_limits<int>::max();
+    int best_width = std::numeric_limits<int>::max(), best_y = 0;
+    bool found = false;
+
+    for (size_t i = 0; i < skyline.size(); i++) {
+        for (int turn = 0; turn < (allow_rotate && w != h ? 2 : 1); turn++) {
+            int rw = turn ? h : w, rh = turn ? w : h, y;
+            if (!fit(i, rw, rh, y))
+                continue;
+
+            // lowest bottom edge wins; ties go to the narrowest segment
+            if (y + rh < best_bottom || (y + rh == best_bottom && skyline[i].w < best_width)) {
+                best_index = i;
+                best_bottom = y + rh;
+                best_width = skyline[i].w;
+                best_y = y;
+                rotated = turn != 0;
+                found = true;
+            }
+        }
+    }
+    if (!found)
+        return false;
+
+    out.x = skyline[best_index].x;
+    out.y = best_y;
+    out.w = rotated ? h : w;
+    out.h = rotated ? w : h;
+
+    // raise the skyline under the new rectangle & cut back whatever it now covers
+    skyline.insert(skyline.begin() + best_index, Segment{ out.x, out.y + out.h, out.w });
+    for (size_t i = best_index + 1; i < skyline.size();) {
+        Segment &prev = skyline[i - 1];
+        Segment &seg = skyline[i];
+        int covered = prev.x + prev.w - seg.x;
+        if (covered <= 0)
+            break;
+
+        seg.x += covered;
+        seg.w -= covered;
+        if (seg.w > 0)
+            break;
+        skyline.erase(skyline.begin() + i);
+    }
+
+    for (size_t i = 0; i + 1 < skyline.size();) {
+        if (skyline[i].y == skyline[i + 1].y) {
+            skyline[i].w += skyline[i + 1].w;
+            skyline.erase(skyline.begin() + i + 1);
+        }
+        else
+            i++;
+    }
+    return true;
+}
+
+// --- TEXTURE ATLAS ------------------------------------------------------------------------------
+
+GenEx::Graphics::TextureAtlas::TextureAtlas(SDL_Renderer *renderer, int page_size, int padding,
+                                            bool allow_rotate) : renderer(renderer),
+                                                                 page_size(page_size),
+                                                                 padding(std::max(padding, 0)),
+                                                                 allow_rotate(allow_rotate) { }
+
+GenEx::Graphics::TextureAtlas::~TextureAtlas() {
+    for (auto &entry : entries)
+        SDL_FreeSurface(entry.surface);
+    for (auto &page : pages)
+        close_page(page);
+}
+
+bool GenEx::Graphics::TextureAtlas::open_page() {
+    SDL_Texture *texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+                                             SDL_TEXTUREACCESS_STATIC, page_size, page_size);
+    if (texture == nullptr)
+        return false;
+
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+    SDL_Surface *mirror = nullptr;
+    GenEx::Graphics::TileRenderer *tiles = GenEx::Graphics::TileRenderer::Get(renderer);
+    if (tiles != nullptr) {
+        mirror = SDL_CreateRGBSurfaceWithFormat(0, page_size, page_size, 32,
+                                                SDL_PIXELFORMAT_ARGB8888);
+        if (mirror == nullptr) {
+            SDL_DestroyTexture(texture);
+            return false;
+        }
+        tiles->add_source(texture, mirror);
+    }
+
+    pages.push_back(Page{ texture, SkylinePacker(page_size, page_size), 0, 0, mirror });
+    return true;
+}
+
+void GenEx::Graphics::TextureAtlas::close_page(Page &page) {
+    GenEx::Graphics::FlushRenderer(renderer); // sprites from this page may still be queued
+    if (page.mirror != nullptr) {
+        GenEx::Graphics::TileRenderer *tiles = GenEx::Graphics::TileRenderer::Get(renderer);
+        if (tiles != nullptr)
+            tiles->remove_source(page.texture);
+        SDL_FreeSurface(page.mirror);
+    }
+    SDL_DestroyTexture(page.texture);
+}
+
+bool GenEx::Graphics::TextureAtlas::place(Entry &entry, size_t first_page) {
+    int w = entry.surface->w + 2 * padding, h = entry.surface->h + 2 * padding;
+    size_t area = (size_t)w * h;
+
+    for (size_t i = first_page; i < pages.size(); i++) {
+        SDL_Rect cell;
+        bool rotated = false;
+        if (!pages[i].packer.insert(w, h, allow_rotate, cell, rotated))
+            continue;
+
+        pages[i].used_area += area;
+        pages[i].live_area += area;
+        assign(entry, i, cell, rotated);
+        return true;
+    }
+    return false;
+}
+
+void GenEx::Graphics::TextureAtlas::assign(Entry &entry, size_t page, const SDL_Rect &cell,
+                                           bool rotated) {
+    entry.page = page;
+    entry.region.texture = pages[page].texture;
+    entry.region.rect = SDL_Rect{ cell.x + padding, cell.y + padding,
+                                  cell.w - 2 * padding, cell.h - 2 * padding };
+    entry.region.rotated = rotated;
+}
+
+bool GenEx::Graphics::TextureAtlas::upload(const Entry &entry) {
+    // the whole cell goes up so the padding around the image is transparent
+    const SDL_Rect &rect = entry.region.rect;
+    SDL_Rect cell = { rect.x - padding, rect.y - padding, rect.w + 2 * padding,
+                      rect.h + 2 * padding };
+    std::vector<Uint32> pixels((size_t)cell.w * cell.h, 0);
+
+    // sprites already queued from this page, batched or tiled, must see the old pixels
+    GenEx::Graphics::FlushRenderer(renderer);
+
+    SDL_Surface *surf = entry.surface;
+    SDL_LockSurface(surf);
+    for (int y = 0; y < rect.h; y++) {
+        Uint32 *row = &pixels[(size_t)(y + padding) * cell.w + padding];
+        for (int x = 0; x < rect.w; x++) {
+            // turned clockwise: the image's left column becomes the top row
+            int sx = entry.region.rotated ? y : x;
+            int sy = entry.region.rotated ? surf->h - 1 - x : y;
+            row[x] = *(Uint32*)((Uint8*)surf->pixels + sy * surf->pitch + sx * 4);
+        }
+    }
+    SDL_UnlockSurface(surf);
+
+    SDL_Surface *mirror = pages[entry.page].mirror;
+    if (mirror != nullptr) {
+        for (int y = 0; y < cell.h; y++)
+            std::copy(&pixels[(size_t)y * cell.w], &pixels[(size_t)(y + 1) * cell.w],
+                      (Uint32*)((Uint8*)mirror->pixels + (cell.y + y) * mirror->pitch) + cell.x);
+    }
+
+    return SDL_UpdateTexture(entry.region.texture, &cell, pixels.data(), cell.w * 4) == 0;
+}
+
+GenEx::Util::SlotHandle GenEx::Graphics::TextureAtlas::add(SDL_Surface *surf) {
+    if (surf == nullptr || surf->w + 2 * padding > page_size ||
+            surf->h + 2 * padding > page_size)
+        return GenEx::Util::NULL_SLOT_HANDLE;
+
+    Entry entry;
+    entry.surface = SDL_ConvertSurfaceFormat(surf, SDL_PIXELFORMAT_ARGB8888, 0);
+    if (entry.surface == nullptr)
+        return GenEx::Util::NULL_SLOT_HANDLE;
+
+    // reclaim removed images' space before growing
+    bool placed = place(entry, 0);
+    if (!placed && get_fragmentation() > repack_threshold && repack())
+        placed = place(entry, 0);
+    if (!placed && open_page())
+        placed = place(entry, pages.size() - 1);
+
+    if (!placed || !upload(entry)) {
+        if (placed) {
+            size_t area = (size_t)(surf->w + 2 * padding) * (surf->h + 2 * padding);
+            pages[entry.page].live_area -= area;
+        }
+        SDL_FreeSurface(entry.surface);
+        return GenEx::Util::NULL_SLOT_HANDLE;
+    }
+    return entries.insert(entry);
+}
+
+bool GenEx::Graphics::TextureAtlas::remove(GenEx::Util::SlotHandle handle) {
+    Entry *entry = entries.get(handle);
+    if (entry == nullptr)
+        return false;
+
+    Page &page = pages[entry->page];
+    page.live_area -= (size_t)(entry->surface->w + 2 * padding) *
+                      (entry->surface->h + 2 * padding);
+    if (page.live_area == 0) {
+        // nothing left on the page; all of it is free again
+        page.packer.clear();
+        page.used_area = 0;
+    }
+
+    SDL_FreeSurface(entry->surface);
+    entries.erase(handle);
+    return true;
+}
+
+const GenEx::Graphics::AtlasRegion *GenEx::Graphics::TextureAtlas::get(
+        GenEx::Util::SlotHandle handle) {
+    Entry *entry = entries.get(handle);
+    return entry != nullptr ? &entry->region : nullptr;
+}
+
+bool GenEx::Graphics::TextureAtlas::repack() {
+    // tallest first leaves the flattest skyline
+    std::vector<size_t> order(entries.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        return entries[a].surface->h > entries[b].surface->h;
+    });
+
+    // lay everything out on fresh packers first; nothing moves unless all of it fits
+    struct Placement {
+        size_t page;
+        SDL_Rect cell;
+        bool rotated;
+    };
+    std::vector<GenEx::Graphics::SkylinePacker> packers(
+        pages.size(), GenEx::Graphics::SkylinePacker(page_size, page_size));
+    std::vector<Placement> placements(entries.size());
+    for (size_t index : order) {
+        const Entry &entry = entries[index];
+        int w = entry.surface->w + 2 * padding, h = entry.surface->h + 2 * padding;
+        Placement &placement = placements[index];
+
+        placement.page = 0;
+        while (placement.page < packers.size() &&
+               !packers[placement.page].insert(w, h, allow_rotate, placement.cell,
+                                               placement.rotated))
+            placement.page++;
+        if (placement.page == packers.size()) {
+            packers.push_back(GenEx::Graphics::SkylinePacker(page_size, page_size));
+            if (!packers.back().insert(w, h, allow_rotate, placement.cell, placement.rotated))
+                return false;
+        }
+    }
+
+    size_t old_pages = pages.size();
+    while (pages.size() < packers.size()) {
+        if (!open_page()) {
+            while (pages.size() > old_pages) {
+                close_page(pages.back());
+                pages.pop_back();
+            }
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < pages.size(); i++) {
+        pages[i].packer = packers[i];
+        pages[i].used_area = 0;
+        pages[i].live_area = 0;
+    }
+    for (size_t index = 0; index < entries.size(); index++) {
+        Entry &entry = entries[index];
+        const Placement &placement = placements[index];
+        size_t area = (size_t)(entry.surface->w + 2 * padding) * (entry.surface->h + 2 * padding);
+        pages[placement.page].used_area += area;
+        pages[placement.page].live_area += area;
+        assign(entry, placement.page, placement.cell, placement.rotated);
+    }
+
+    while (!pages.empty() && pages.back().used_area == 0) {
+        close_page(pages.back());
+        pages.pop_back();
+    }
+
+    bool ok = true;
+    for (auto &entry : entries)
+        ok = upload(entry) && ok;
+    return ok;
+}
+
+void GenEx::Graphics::TextureAtlas::set_repack_threshold(double threshold) {
+    repack_threshold = threshold;
+}
+
+double GenEx::Graphics::TextureAtlas::get_fragmentation() {
+    size_t used = 0, live = 0;
+    for (auto &page : pages) {
+        used += page.used_area;
+        live += page.live_area;
+    }
+    return used > 0 ? (double)(used - live) / used : 0.0;
+}
+
+size_t GenEx::Graphics::TextureAtlas::num_pages() { return pages.size(); }
+
+size_t GenEx::Graphics::TextureAtlas::size() { return entries.size(); }
+
+bool GenEx::Graphics::RenderImg(const GenEx::Graphics::AtlasRegion &region, SDL_Renderer *target,
+                                float x, float y, float offset_x, float offset_y, float anchor_x,
+                                float anchor_y, double rotation, float scale_x, float scale_y,
+                                bool flip_horizontal, bool flip_vertical) {
+    SDL_Rect clip = region.rect;
+    if (!region.rotated)
+        return GenEx::Graphics::RenderImg(region.texture, target, x, y, &clip, offset_x, offset_y,
+                                          anchor_x, anchor_y, rotation, scale_x, scale_y,
+                                          flip_horizontal, flip_vertical);
+
+    // draw the sideways cell around the upright image's centre & turn it back; the image's
+    // axes are the cell's swapped, and so are its scales & flips
+    float w = scale_x * clip.h, h = scale_y * clip.w;
+    float cx = x - w * anchor_x + w / 2, cy = y - h * anchor_y + h / 2;
+    return GenEx::Graphics::RenderImg(region.texture, target, cx, cy, &clip, offset_x, offset_y,
+                                      0.5f, 0.5f, rotation - 90.0, scale_y, scale_x,
+                                      flip_vertical, flip_horizontal);
+}
+
+// --- TEXTURE CACHE ------------------------------------------------------------------------------
+
+namespace {
+    std::unordered_map<SDL_Surface*, Uint32> surface_versions;
+    SDL_SpinLock surface_versions_lock = 0;
+    std::atomic<bool> any_surface_versions(false); // skips the lock until something changes
+
+    std::unordered_map<SDL_Renderer*, GenEx::Graphics::TextureCache*> texture_caches;
+    SDL_SpinLock texture_caches_lock = 0;
+
+    Uint32 GetSurfaceVersion(SDL_Surface *surf) {
+        if (!any_surface_versions.load(std::memory_order_acquire))
+            return 0;
+
+        SDL_AtomicLock(&surface_versions_lock);
+        auto it = surface_versions.find(surf);
+        Uint32 version = it != surface_versions.end() ? it->second : 0;
+        SDL_AtomicUnlock(&surface_versions_lock);
+        return version;
+    }
+
+    void ForgetSurfaceVersion(SDL_Surface *surf) {
+        if (!any_surface_versions.load(std::memory_order_acquire))
+            return;
+
+        SDL_AtomicLock(&surface_versions_lock);
+        surface_versions.erase(surf);
+        SDL_AtomicUnlock(&surface_versions_lock);
+    }
+
+    // a texture about to be destroyed may still be queued
+    void FlushBatch(SDL_Renderer *renderer) {
+        GenEx::Graphics::SpriteBatch *batch = GenEx::Graphics::SpriteBatch::GetActive(renderer);
+        if (batch != nullptr)
+            batch->flush();
+    }
+}
+
+void GenEx::Graphics::MarkSurfaceChanged(SDL_Surface *surf) {
+    SDL_AtomicLock(&surface_versions_lock);
+    surface_versions[surf]++;
+    any_surface_versions.store(true, std::memory_order_release);
+    SDL_AtomicUnlock(&surface_versions_lock);
+}
+
+GenEx::Graphics::TextureCache::TextureCache(SDL_Renderer *renderer, size_t budget) :
+        renderer(renderer), budget(budget) {
+    SDL_AtomicLock(&texture_caches_lock);
+    texture_caches[renderer] = this;
+    SDL_AtomicUnlock(&texture_caches_lock);
+}
+
+GenEx::Graphics::TextureCache::~TextureCache() {
+    SDL_AtomicLock(&texture_caches_lock);
+    auto it = texture_caches.find(renderer);
+    if (it != texture_caches.end() && it->second == this)
+        texture_caches.erase(it);
+    SDL_AtomicUnlock(&texture_caches_lock);
+
+    clear();
+}
+
+GenEx::Graphics::TextureCache *GenEx::Graphics::TextureCache::Get(SDL_Renderer *renderer) {
+    SDL_AtomicLock(&texture_caches_lock);
+    auto it = texture_caches.find(renderer);
+    GenEx::Graphics::TextureCache *cache = it != texture_caches.end() ? it->second : nullptr;
+    SDL_AtomicUnlock(&texture_caches_lock);
+    return cache;
+}
+
+void GenEx::Graphics::TextureCache::destroy_entry(std::list<Entry>::iterator it) {
+    release(*it);
+    usage -= it->bytes;
+    lookup.erase(it->surface);
+    entries.erase(it);
+}
+
+void GenEx::Graphics::TextureCache::release(const Entry &entry) {
+    if (entry.copy != nullptr) {
+        GenEx::Graphics::TileRenderer *tiles = GenEx::Graphics::TileRenderer::Get(renderer);
+        if (tiles != nullptr)
+            tiles->remove_source(entry.texture);
+        SDL_FreeSurface(entry.copy);
+    }
+    SDL_DestroyTexture(entry.texture);
+
+    // drops the reference get() took; frees the surface if its owner already has
+    if (entry.referenced)
+        SDL_FreeSurface(entry.surface);
+}
+
+void GenEx::Graphics::TextureCache::evict() {
+    if (usage <= budget || entries.size() <= 1)
+        return;
+
+    // never the texture that was just asked for
+    FlushBatch(renderer);
+    while (usage > budget && entries.size() > 1) {
+        auto last = std::prev(entries.end());
+        ForgetSurfaceVersion(last->surface);
+        destroy_entry(last);
+    }
+}
+
+SDL_Texture *GenEx::Graphics::TextureCache::get(SDL_Surface *surf) {
+    if (surf->format == nullptr)
+        return nullptr;
+
+    Uint32 version = GetSurfaceVersion(surf);
+    Uint32 format = surf->format->format;
+
+    auto found = lookup.find(surf);
+    if (found != lookup.end()) {
+        auto it = found->second;
+        if (it->pixels == surf->pixels && it->w == surf->w &&
+                it->h == surf->h && it->pitch == surf->pitch && it->format == format &&
+                it->version == version) {
+            hits++;
+            entries.splice(entries.begin(), entries, it);
+
+            Uint8 r, g, b, a;
+            SDL_BlendMode blend;
+            SDL_GetSurfaceColorMod(surf, &r, &g, &b);
+            SDL_GetSurfaceAlphaMod(surf, &a);
+            SDL_GetSurfaceBlendMode(surf, &blend);
+            SDL_SetTextureColorMod(it->texture, r, g, b);
+            SDL_SetTextureAlphaMod(it->texture, a);
+            SDL_SetTextureBlendMode(it->texture, blend);
+            return it->texture;
+        }
+
+        FlushBatch(renderer);
+        destroy_entry(it);
+    }
+
+    misses++;
+    SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surf);
+    if (texture == nullptr)
+        return nullptr;
+
+    Entry entry = { surf, texture, surf->pixels, surf->w, surf->h, surf->pitch, format, version,
+                    (size_t)surf->w * surf->h * 4, nullptr, false };
+
+    // holding a reference keeps the address from being reused by another surface while it's
+    // cached; SDL never frees SDL_DONTFREE surfaces, so they don't need one
+    if (!(surf->flags & SDL_DONTFREE)) {
+        surf->refcount++;
+        entry.referenced = true;
+    }
+
+    // a tile renderer reads the pixels itself, from a copy in its format
+    GenEx::Graphics::TileRenderer *tiles = GenEx::Graphics::TileRenderer::Get(renderer);
+    if (tiles != nullptr) {
+        entry.copy = SDL_ConvertSurfaceFormat(surf, SDL_PIXELFORMAT_ARGB8888, 0);
+        if (entry.copy != nullptr) {
+            tiles->add_source(texture, entry.copy);
+            entry.bytes *= 2;
+        }
+    }
+    entries.push_front(entry);
+    lookup[surf] = entries.begin();
+    usage += entry.bytes;
+
+    evict();
+    return texture;
+}
+
+void GenEx::Graphics::TextureCache::forget(SDL_Surface *surf) {
+    auto found = lookup.find(surf);
+    if (found == lookup.end())
+        return;
+
+    FlushBatch(renderer);
+    destroy_entry(found->second);
+    ForgetSurfaceVersion(surf);
+}
+
+void GenEx::Graphics::TextureCache::sweep() {
+    bool flushed = false;
+    for (auto it = entries.begin(); it != entries.end();) {
+        auto next = std::next(it);
+
+        // the cache's reference is the only one left, so the owner has freed the surface
+        if (it->referenced && it->surface->refcount <= 1) {
+            if (!flushed) {
+                FlushBatch(renderer);
+                flushed = true;
+            }
+            ForgetSurfaceVersion(it->surface);
+            destroy_entry(it);
+        }
+        it = next;
+    }
+}
+
+void GenEx::Graphics::TextureCache::clear() {
+    if (entries.empty())
+        return;
+
+    FlushBatch(renderer);
+    for (auto &entry : entries) {
+        release(entry);
+        ForgetSurfaceVersion(entry.surface);
+    }
+    entries.clear();
+    lookup.clear();
+    usage = 0;
+}
+
+void GenEx::Graphics::TextureCache::set_budget(size_t bytes) {
+    budget = bytes;
+    evict();
+}
+
+size_t GenEx::Graphics::TextureCache::get_budget() { return budget; }
+
+size_t GenEx::Graphics::TextureCache::get_memory_usage() { return usage; }
+
+size_t GenEx::Graphics::TextureCache::size() { return entries.size(); }
+
+size_t GenEx::Graphics::TextureCache::get_hits() { return hits; }
+
+size_t GenEx::Graphics::TextureCache::get_misses() { return misses; }
+
+// --- LINE RASTERIZER ----------------------------------------------------------------------------
+
+namespace {
+    std::unordered_map<SDL_Renderer*, GenEx::Graphics::LineRasterizer*> line_rasterizers;
+    SDL_SpinLock line_rasterizers_lock = 0;
+
+    SDL_Point GetTargetSize(SDL_Renderer *renderer) {
+        SDL_Point size = { 0, 0 };
+        SDL_Texture *target = SDL_GetRenderTarget(renderer);
+        if (target != nullptr) {
+            SDL_QueryTexture(target, nullptr, nullptr, &size.x, &size.y);
+            return size;
+        }
+
+        // draws are in logical coordinates when a logical size is set
+        SDL_RenderGetLogicalSize(renderer, &size.x, &size.y);
+        if (size.x == 0 || size.y == 0)
+            SDL_GetRendererOutputSize(renderer, &size.x, &size.y);
+        return size;
+    }
+
+    // narrows [lo, hi] to where coef * x >= k
+    void Constrain(float coef, float k, float &lo, float &hi) {
+        if (coef > 1e-6f)
+            lo = std::max(lo, k / coef);
+        else if (coef < -1e-6f)
+            hi = std::min(hi, k / coef);
+        else if (k > 0.f)
+            hi = lo - 1.f;
+    }
+}
+
+GenEx::Graphics::LineRasterizer::LineRasterizer(SDL_Renderer *renderer) : renderer(renderer) {
+    SDL_AtomicLock(&line_rasterizers_lock);
+    line_rasterizers[renderer] = this;
+    SDL_AtomicUnlock(&line_rasterizers_lock);
+}
+
+GenEx::Graphics::LineRasterizer::LineRasterizer(SDL_Renderer *renderer, SDL_Rect bounds) :
+    renderer(renderer), bounded(true), bounds(bounds) { }
+
+GenEx::Graphics::LineRasterizer::~LineRasterizer() {
+    SDL_AtomicLock(&line_rasterizers_lock);
+    auto it = line_rasterizers.find(renderer);
+    if (it != line_rasterizers.end() && it->second == this)
+        line_rasterizers.erase(it);
+    SDL_AtomicUnlock(&line_rasterizers_lock);
+
+    if (texture != nullptr)
+        SDL_DestroyTexture(texture);
+}
+
+GenEx::Graphics::LineRasterizer *GenEx::Graphics::LineRasterizer::Get(SDL_Renderer *renderer) {
+    SDL_AtomicLock(&line_rasterizers_lock);
+    auto it = line_rasterizers.find(renderer);
+    GenEx::Graphics::LineRasterizer *raster = it != line_rasterizers.end() ? it->second : nullptr;
+    SDL_AtomicUnlock(&line_rasterizers_lock);
+    return raster;
+}
+
+bool GenEx::Graphics::LineRasterizer::fit_target() {
+    SDL_Point size = GetTargetSize(renderer);
+    SDL_Rect area = { 0, 0, size.x, size.y };
+    if (size.x <= 0 || size.y <= 0 || (bounded && !SDL_IntersectRect(&bounds, &area, &area)))
+        return false;
+    if (texture != nullptr && area.w == width && area.h == height)
+        return true;
+
+    // the target changed size; what's pending was meant for the old one
+    flush();
+    if (texture != nullptr)
+        SDL_DestroyTexture(texture);
+
+    texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+                                SDL_TEXTUREACCESS_STREAMING, area.w, area.h);
+    if (texture == nullptr) {
+        width = height = 0;
+        return false;
+    }
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+    width = area.w;
+    height = area.h;
+    origin_x = area.x;
+    origin_y = area.y;
+    coverage.assign((size_t)width * height, 0);
+    spans.assign(height, SDL_Point{ 0, 0 });
+    pixels.assign((size_t)width * height, 0);
+    return true;
+}
+
+void GenEx::Graphics::LineRasterizer::mark(SDL_Rect &dirty, const SDL_Rect &rect) {
+    if (dirty.w <= 0)
+        dirty = rect;
+    else
+        SDL_UnionRect(&dirty, &rect, &dirty);
+}
+
+void GenEx::Graphics::LineRasterizer::mark_row(int y, int x, int x_end) {
+    SDL_Point &span = spans[y];
+    if (span.y <= span.x)
+        span = SDL_Point{ x, x_end };
+    else
+        span = SDL_Point{ std::min(span.x, x), std::max(span.y, x_end) };
+    mark(path_dirty, SDL_Rect{ x, y, x_end - x, 1 });
+}
+
+void GenEx::Graphics::LineRasterizer::cover_polygon(const float *xy, int n) {
+    // convex & at most 5 corners; either winding
+    float nx[5], ny[5], c[5];
+    float area = 0.f;
+    for (int i = 0; i < n; i++) {
+        int j = (i + 1) % n;
+        area += xy[2 * i] * xy[2 * j + 1] - xy[2 * j] * xy[2 * i + 1];
+    }
+    if (std::fabs(area) < 1e-6f)
+        return;
+
+    float min_x = xy[0], max_x = xy[0], min_y = xy[1], max_y = xy[1];
+    int edges = 0;
+    for (int i = 0; i < n; i++) {
+        int j = (i + 1) % n;
+        float ex = xy[2 * j] - xy[2 * i], ey = xy[2 * j + 1] - xy[2 * i + 1];
+        float len = std::sqrt(ex * ex + ey * ey);
+        min_x = std::min(min_x, xy[2 * i]);
+        max_x = std::max(max_x, xy[2 * i]);
+        min_y = std::min(min_y, xy[2 * i + 1]);
+        max_y = std::max(max_y, xy[2 * i + 1]);
+        if (len < 1e-6f)
+            continue;
+
+        // inward unit normal; signed distance inside is n . p - c
+        float s = area > 0.f ? 1.f : -1.f;
+        nx[edges] = -ey / len * s;
+        ny[edges] = ex / len * s;
+        c[edges] = nx[edges] * xy[2 * i] + ny[edges] * xy[2 * i + 1];
+        edges++;
+    }
+
+    int row0 = std::max(0, (int)std::floor(min_y - 0.5f));
+    int row1 = std::min(height - 1, (int)std::ceil(max_y + 0.5f));
+    for (int y = row0; y <= row1; y++) {
+        float py = y + 0.5f;
+
+        // pixel centres more than half a pixel outside any edge are uncovered
+        float lo = min_x - 1.f, hi = max_x + 1.f;
+        for (int e = 0; e < edges; e++)
+            Constrain(nx[e], c[e] - 0.5f - ny[e] * py, lo, hi);
+
+        int x0 = std::max(0, (int)std::ceil(lo - 0.5f));
+        int x1 = std::min(width - 1, (int)std::floor(hi - 0.5f));
+        if (x0 > x1)
+            continue;
+
+        Uint8 *row = &coverage[(size_t)y * width];
+        for (int x = x0; x <= x1; x++) {
+            float px = x + 0.5f, dist = 1.f;
+            for (int e = 0; e < edges; e++)
+                dist = std::min(dist, nx[e] * px + ny[e] * py - c[e]);
+
+            float cov = std::min(std::max(dist + 0.5f, 0.f), 1.f);
+            Uint8 value = (Uint8)(cov * alpha_scale * 255.f + 0.5f);
+            if (value > row[x])
+                row[x] = value;
+        }
+        mark_row(y, x0, x1 + 1);
+    }
+}
+
+void GenEx::Graphics::LineRasterizer::cover_capsule(float ax, float ay, float bx, float by,
+                                                    float r) {
+    float dx = bx - ax, dy = by - ay;
+    float len2 = dx * dx + dy * dy, len = std::sqrt(len2);
+    float reach = r + 0.5f; // coverage ends half a pixel past the edge
+
+    int row0 = std::max(0, (int)std::floor(std::min(ay, by) - reach));
+    int row1 = std::min(height - 1, (int)std::ceil(std::max(ay, by) + reach));
+    for (int y = row0; y <= row1; y++) {
+        float py = y + 0.5f;
+
+        // the row crosses the capsule in one stretch: the union of both end discs & the
+        // band between them
+        float lo = std::numeric_limits<float>::max(), hi = -lo;
+        for (int end = 0; end < 2; end++) {
+            float cx = end ? bx : ax, cy = end ? by : ay;
+            float t = reach * reach - (py - cy) * (py - cy);
+            if (t > 0.f) {
+                lo = std::min(lo, cx - std::sqrt(t));
+                hi = std::max(hi, cx + std::sqrt(t));
+            }
+        }
+        if (len > 1e-6f) {
+            float band_lo = std::min(ax, bx) - reach, band_hi = std::max(ax, bx) + reach;
+            Constrain(dy, (py - ay) * dx - reach * len + ax * dy, band_lo, band_hi);
+            Constrain(-dy, -(py - ay) * dx - reach * len - ax * dy, band_lo, band_hi);
+            Constrain(dx, ax * dx - (py - ay) * dy, band_lo, band_hi);
+            Constrain(-dx, -len2 - ax * dx + (py - ay) * dy, band_lo, band_hi);
+            if (band_lo <= band_hi) {
+                lo = std::min(lo, band_lo);
+                hi = std::max(hi, band_hi);
+            }
+        }
+
+        int x0 = std::max(0, (int)std::ceil(lo - 0.5f));
+        int x1 = std::min(width - 1, (int)std::floor(hi - 0.5f));
+        if (x0 > x1)
+            continue;
+
+        Uint8 *row = &coverage[(size_t)y * width];
+        for (int x = x0; x <= x1; x++) {
+            float px = x + 0.5f;
+            float t = len2 > 1e-12f ? ((px - ax) * dx + (py - ay) * dy) / len2 : 0.f;
+            t = std::min(std::max(t, 0.f), 1.f);
+            float ex = px - (ax + t * dx), ey = py - (ay + t * dy);
+
+            float cov = std::min(std::max(reach - std::sqrt(ex * ex + ey * ey), 0.f), 1.f);
+            Uint8 value = (Uint8)(cov * alpha_scale * 255.f + 0.5f);
+            if (value > row[x])
+                row[x] = value;
+        }
+        mark_row(y, x0, x1 + 1);
+    }
+}
+
+void GenEx::Graphics::LineRasterizer::cover_segment(float back, float front) {
+    // pieces meeting edge to edge would each only half cover the pixels on the seam, so a
+    // segment reaches a little under whatever is attached to its ends
+    float nx = -last_uy * radius, ny = last_ux * radius;
+    float ax = prev_x - last_ux * back, ay = prev_y - last_uy * back;
+    float bx = last_x + last_ux * front, by = last_y + last_uy * front;
+    float quad[8] = { ax + nx, ay + ny, bx + nx, by + ny, bx - nx, by - ny, ax - nx, ay - ny };
+    cover_polygon(quad, 4);
+}
+
+void GenEx::Graphics::LineRasterizer::cover_cap(float x, float y, float ux, float uy) {
+    // (ux, uy) points away from the line
+    float nx = -uy * radius, ny = ux * radius;
+    switch (cap) {
+    case GenEx::Graphics::CAP_ROUND:
+        cover_capsule(x, y, x, y, radius);
+        break;
+    case GenEx::Graphics::CAP_SQUARE: {
+        float ex = ux * radius, ey = uy * radius;
+        float quad[8] = { x + nx, y + ny, x + nx + ex, y + ny + ey,
+                          x - nx + ex, y - ny + ey, x - nx, y - ny };
+        cover_polygon(quad, 4);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void GenEx::Graphics::LineRasterizer::cover_join(float x, float y, float u0x, float u0y,
+                                                 float u1x, float u1y) {
+    float cross = u0x * u1y - u0y * u1x, dot = u0x * u1x + u0y * u1y;
+    if (std::fabs(cross) < 1e-6f && dot > 0.f)
+        return; // straight on
+
+    if (join == GenEx::Graphics::JOIN_ROUND) {
+        cover_capsule(x, y, x, y, radius);
+        return;
+    }
+
+    // the corners on the outside of the turn
+    float side = cross > 0.f ? -radius : radius;
+    float ax = x - u0y * side, ay = y + u0x * side;
+    float bx = x - u1y * side, by = y + u1x * side;
+
+    // a corner right on the shared point would leave it half covered, so the join starts a
+    // little way back on the inside of the turn
+    float mx = ax - x + bx - x, my = ay - y + by - y;
+    float m = std::sqrt(mx * mx + my * my);
+    float ix = m > 1e-6f ? x - mx / m * overlap : x, iy = m > 1e-6f ? y - my / m * overlap : y;
+
+    // a miter's length over the half width is 1 / cos(half the turn)
+    if (join == GenEx::Graphics::JOIN_MITER && 1.f + dot > 1e-6f &&
+            2.f / (1.f + dot) <= miter_limit * miter_limit) {
+        float quad[8] = { ix, iy, ax, ay, x + mx / (1.f + dot), y + my / (1.f + dot), bx, by };
+        cover_polygon(quad, 4);
+        return;
+    }
+
+    float tri[6] = { ix, iy, ax, ay, bx, by };
+    cover_polygon(tri, 3);
+}
+
+void GenEx::Graphics::LineRasterizer::composite() {
+    if (path_dirty.w <= 0)
+        return;
+
+    Uint32 rgb = ((Uint32)color.r << 16) | ((Uint32)color.g << 8) | color.b;
+    for (int y = path_dirty.y; y < path_dirty.y + path_dirty.h; y++) {
+        SDL_Point span = spans[y];
+        spans[y] = SDL_Point{ 0, 0 };
+
+        Uint8 *cov = &coverage[(size_t)y * width];
+        Uint32 *dst = &pixels[(size_t)y * width];
+        for (int x = span.x; x < span.y; x++) {
+            if (cov[x] == 0)
+                continue;
+
+            Uint32 src_a = (color.a * cov[x] + 127) / 255;
+            cov[x] = 0;
+            Uint32 dst_a = dst[x] >> 24;
+            if (dst_a == 0 || src_a == 255) {
+                if (src_a > 0)
+                    dst[x] = (src_a << 24) | rgb;
+                continue;
+            }
+
+            // "over" in straight alpha
+            Uint32 keep = dst_a * (255 - src_a) / 255;
+            Uint32 out_a = src_a + keep;
+            Uint32 out = out_a << 24;
+            for (int shift = 0; shift < 24; shift += 8) {
+                Uint32 s = (rgb >> shift) & 0xFF, d = (dst[x] >> shift) & 0xFF;
+                out |= ((s * src_a + d * keep) / out_a) << shift;
+            }
+            dst[x] = out;
+        }
+    }
+
+    mark(frame_dirty, path_dirty);
+    path_dirty = SDL_Rect{ 0, 0, 0, 0 };
+}
+
+void GenEx::Graphics::LineRasterizer::begin() { depth++; }
+
+void GenEx::Graphics::LineRasterizer::end() {
+    if (depth > 0 && --depth == 0)
+        flush();
+}
+
+void GenEx::Graphics::LineRasterizer::line(float x0, float y0, float x1, float y1, float width,
+                                           SDL_Color color, GenEx::Graphics::LineCap cap) {
+    begin_path(width, color, cap);
+    line_to(x0, y0);
+    line_to(x1, y1);
+    end_path();
+}
+
+void GenEx::Graphics::LineRasterizer::begin_path(float width, SDL_Color color,
+                                                 GenEx::Graphics::LineCap cap,
+                                                 GenEx::Graphics::LineJoin join,
+                                                 float miter_limit) {
+    if (path_ok)
+        end_path();
+
+    path_ok = fit_target();
+    this->color = color;
+    this->cap = cap;
+    this->join = join;
+    this->miter_limit = miter_limit;
+    if (width <= 0.f)
+        width = 1.f; // a hairline, as the renderer's own lines are
+    radius = std::max(width, 1.f) / 2.f;
+    alpha_scale = std::min(std::max(width, 0.f), 1.f);
+    overlap = std::min(radius, 1.f);
+    num_points = 0;
+}
+
+void GenEx::Graphics::LineRasterizer::line_to(float x, float y) {
+    if (!path_ok)
+        return;
+    x -= origin_x;
+    y -= origin_y;
+
+    if (num_points == 0) {
+        start_x = last_x = x;
+        start_y = last_y = y;
+        num_points = 1;
+        return;
+    }
+
+    float dx = x - last_x, dy = y - last_y;
+    float len = std::sqrt(dx * dx + dy * dy);
+    if (len < 1e-4f)
+        return;
+
+    // the previous segment is only drawn once it's known what its far end meets
+    float ux = dx / len, uy = dy / len;
+    if (num_points == 1) {
+        first_ux = ux;
+        first_uy = uy;
+        prev_overlap = cap == GenEx::Graphics::CAP_BUTT ? 0.f : overlap;
+    }
+    else {
+        cover_segment(prev_overlap, overlap);
+        cover_join(last_x, last_y, last_ux, last_uy, ux, uy);
+        prev_overlap = overlap;
+    }
+
+    prev_x = last_x;
+    prev_y = last_y;
+    last_x = x;
+    last_y = y;
+    last_ux = ux;
+    last_uy = uy;
+    num_points++;
+}
+
+void GenEx::Graphics::LineRasterizer::end_path() {
+    if (!path_ok)
+        return;
+    path_ok = false;
+
+    if (num_points == 1 && cap != GenEx::Graphics::CAP_BUTT) {
+        // a lone point is just its caps
+        cover_cap(start_x, start_y, -1.f, 0.f);
+        cover_cap(start_x, start_y, 1.f, 0.f);
+    }
+    else if (num_points > 1) {
+        cover_segment(prev_overlap, cap == GenEx::Graphics::CAP_BUTT ? 0.f : overlap);
+        cover_cap(start_x, start_y, -first_ux, -first_uy);
+        cover_cap(last_x, last_y, last_ux, last_uy);
+    }
+
+    composite();
+    if (depth == 0)
+        flush();
 }
 
-bool GenEx::Graphics::RenderImg(SDL_Surface *surf, SDL_Renderer *target, float x, float y,
-                                SDL_Rect *clipping_rect, float offset_x, float offset_y,
-                                float anchor_x, float anchor_y, double rotation, float scale_x,
-                                float scale_y, bool flip_horizontal, bool flip_vertical) {
-    SDL_Texture *tex = SDL_CreateTextureFromSurface(target, surf);
-    if (tex == nullptr) {
-        return false;
+void GenEx::Graphics::LineRasterizer::flush() {
+    if (frame_dirty.w <= 0 || texture == nullptr)
+        return;
+
+    FlushBatch(renderer);
+
+    SDL_Rect rect = frame_dirty;
+    SDL_Rect dst = { rect.x + origin_x, rect.y + origin_y, rect.w, rect.h };
+    Uint32 *first = &pixels[(size_t)rect.y * width + rect.x];
+    GenEx::Graphics::TileRenderer *tiles = GetTileRenderer(renderer);
+    if (tiles != nullptr)
+        tiles->draw_pixels(first, width, dst);
+    else {
+        SDL_UpdateTexture(texture, &rect, first, width * 4);
+        SDL_RenderCopy(renderer, texture, &rect, &dst);
     }
-    bool ret_val = GenEx::Graphics::RenderImg(tex, target, x, y, clipping_rect, offset_x, offset_y,
-                                              anchor_x, anchor_y, rotation, scale_x, scale_y,
-                                              flip_horizontal, flip_vertical);
-    SDL_DestroyTexture(tex);
-    return ret_val;
+
+    for (int y = 0; y < rect.h; y++)
+        std::fill(first + (size_t)y * width, first + (size_t)y * width + rect.w, 0);
+    frame_dirty = SDL_Rect{ 0, 0, 0, 0 };
 }
 
-void GenEx::Graphics::RenderLine(SDL_Renderer *target, SDL_Color color,
-                                 int x0, int y0, int x1, int y1, float wd) {
-    Uint8 r,g,b,a;
-    SDL_BlendMode blend_mode;
-    SDL_GetRenderDrawColor(target, &r, &g, &b, &a);
-    SDL_GetRenderDrawBlendMode(target, &blend_mode);
+// --- TILE RENDERER ------------------------------------------------------------------------------
+
+namespace {
+    std::unordered_map<SDL_Renderer*, GenEx::Graphics::TileRenderer*> tile_renderers;
+    SDL_SpinLock tile_renderers_lock = 0;
+
+    inline Uint32 Div255(Uint32 x) { return (x + 128 + ((x + 128) >> 8)) >> 8; }
+
+    /* dst = src over dst for straight-alpha ARGB8888; out alpha = sa + da * (1 - sa) */
+    void BlendSpan(Uint32 *dst, const Uint32 *src, int count) {
+        int i = 0;
+#ifdef __SSE2__
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i half = _mm_set1_epi16(128);
+        const __m128i full = _mm_set1_epi16(255);
+        const __m128i alpha_lanes = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+        for (; i + 4 <= count; i += 4) {
+            __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+            int opaque = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_srli_epi32(s, 24),
+                                                          _mm_set1_epi32(255)));
+            if (opaque == 0xFFFF) {
+                _mm_storeu_si128((__m128i*)(dst + i), s);
+                continue;
+            }
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_srli_epi32(s, 24), zero)) == 0xFFFF)
+                continue;
+
+            __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+            __m128i out[2];
+            for (int half_index = 0; half_index < 2; half_index++) {
+                __m128i s16 = half_index == 0 ? _mm_unpacklo_epi8(s, zero) :
+                                                _mm_unpackhi_epi8(s, zero);
+                __m128i d16 = half_index == 0 ? _mm_unpacklo_epi8(d, zero) :
+                                                _mm_unpackhi_epi8(d, zero);
+                __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s16, 0xFF), 0xFF);
+
+                // the alpha lane blends 255 over the destination's alpha
+                s16 = _mm_or_si128(_mm_andnot_si128(alpha_lanes, s16), alpha_lanes);
+                __m128i x = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(s16, a), half),
+                                          _mm_mullo_epi16(d16, _mm_sub_epi16(full, a)));
+                out[half_index] = _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+            }
+            _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(out[0], out[1]));
+        }
+#endif
+        for (; i < count; i++) {
+            Uint32 s = src[i], a = s >> 24;
+            if (a == 255)
+                dst[i] = s;
+            else if (a > 0) {
+                Uint32 d = dst[i], out = 0;
+                for (int shift = 0; shift < 24; shift += 8)
+                    out |= Div255(((s >> shift) & 0xFF) * a +
+                                  ((d >> shift) & 0xFF) * (255 - a)) << shift;
+                dst[i] = out | (a + Div255((d >> 24) * (255 - a))) << 24;
+            }
+        }
+    }
 
-    std::map<Uint8, std::vector<SDL_Point> > alpha_map;
+    /* the rest of SDL's blend modes; rare enough to stay scalar */
+    void BlendSpanSlow(Uint32 *dst, const Uint32 *src, int count, SDL_BlendMode blend) {
+        for (int i = 0; i < count; i++) {
+            Uint32 s = src[i], d = dst[i], a = s >> 24;
+            if (blend == SDL_BLENDMODE_NONE) {
+                dst[i] = s;
+                continue;
+            }
 
-    bool steep = SDL_abs(y1-y0) > SDL_abs(x1-x0);
-    if (steep) {
-        std::swap(x0, y0);
-        std::swap(x1, y1);
+            Uint32 out = d & 0xFF000000;
+            for (int shift = 0; shift < 24; shift += 8) {
+                Uint32 sc = (s >> shift) & 0xFF, dc = (d >> shift) & 0xFF;
+                Uint32 c = blend == SDL_BLENDMODE_ADD ? std::min(dc + Div255(sc * a), 255u) :
+                                                        Div255(sc * dc);
+                out |= c << shift;
+            }
+            dst[i] = out;
+        }
     }
 
-    if (x0 > x1) {
-        std::swap(x0, x1);
-        std::swap(y0, y1);
+    inline Uint32 Modulate(Uint32 texel, SDL_Color color) {
+        return Div255((texel >> 24) * color.a) << 24 |
+               Div255(((texel >> 16) & 0xFF) * color.r) << 16 |
+               Div255(((texel >> 8) & 0xFF) * color.g) << 8 | Div255((texel & 0xFF) * color.b);
     }
+}
+
+GenEx::Graphics::TileRenderer::TileRenderer(SDL_Renderer *renderer, SDL_Surface *target) :
+        renderer(renderer), target(target) {
+    tiles_x = (target->w + GenEx::Graphics::TILE_SIZE - 1) / GenEx::Graphics::TILE_SIZE;
+    tiles_y = (target->h + GenEx::Graphics::TILE_SIZE - 1) / GenEx::Graphics::TILE_SIZE;
+    bins.resize((size_t)tiles_x * tiles_y);
 
-    // compute the slope
-    float dx = x1-x0;
-    float dy = y1-y0;
-    float gradient = dy/dx;
-    if (dx == 0.0)
-        gradient = 1;
+    SDL_AtomicLock(&tile_renderers_lock);
+    tile_renderers[renderer] = this;
+    SDL_AtomicUnlock(&tile_renderers_lock);
+}
 
-    int xpxl1 = x0;
-    int xpxl2 = x1;
-    float intersectY = y0;
+GenEx::Graphics::TileRenderer::~TileRenderer() {
+    SDL_AtomicLock(&tile_renderers_lock);
+    auto it = tile_renderers.find(renderer);
+    if (it != tile_renderers.end() && it->second == this)
+        tile_renderers.erase(it);
+    SDL_AtomicUnlock(&tile_renderers_lock);
+}
 
-    // main loop
-    if (steep) {
-        for (int x = xpxl1 ; x <=xpxl2 ; x++) {
-            alpha_map[(Uint8) (255*freciprocal(intersectY))].emplace_back(
-                SDL_Point{ (int)intersectY, x }
-            );
-            alpha_map[(Uint8) (255*fracofnum(intersectY))].emplace_back(
-                SDL_Point{ (int)intersectY+1, x }
-            );
-            intersectY += gradient;
-        }
-    }
-    else {
-        for (int x = xpxl1 ; x <=xpxl2 ; x++) {
-            alpha_map[(Uint8) (255*freciprocal(intersectY))].emplace_back(
-                SDL_Point{ x, (int)intersectY }
-            );
-            alpha_map[(Uint8) (255*fracofnum(intersectY))].emplace_back(
-                SDL_Point{ x, (int)intersectY+1 }
-            );
-            intersectY += gradient;
-        }
-    }
+GenEx::Graphics::TileRenderer *GenEx::Graphics::TileRenderer::Get(SDL_Renderer *renderer) {
+    SDL_AtomicLock(&tile_renderers_lock);
+    auto it = tile_renderers.find(renderer);
+    GenEx::Graphics::TileRenderer *tiles = it != tile_renderers.end() ? it->second : nullptr;
+    SDL_AtomicUnlock(&tile_renderers_lock);
+    return tiles;
+}
 
-    SDL_SetRenderDrawBlendMode(target, SDL_BLENDMODE_BLEND);
-    for (auto &iter : alpha_map) {
-        if (iter.first > 0) {
-            SDL_SetRenderDrawColor(target, color.r, color.g, color.b,
-                                   (Uint8)(color.a*(iter.first / 255.f)));
-            SDL_Point *parr = &(iter.second)[0];
-            SDL_RenderDrawPoints(target, parr, iter.second.size());
+void GenEx::Graphics::TileRenderer::add_source(SDL_Texture *texture, const SDL_Surface *source) {
+    sources[texture] = source;
+}
+
+void GenEx::Graphics::TileRenderer::remove_source(SDL_Texture *texture) {
+    auto it = sources.find(texture);
+    if (it == sources.end())
+        return;
+
+    flush();
+    sources.erase(it);
+}
+
+void GenEx::Graphics::TileRenderer::bin(const Command &command) {
+    Uint32 index = commands.size();
+    commands.push_back(command);
+
+    const SDL_Rect &b = command.bounds;
+    int tx0 = b.x / GenEx::Graphics::TILE_SIZE, tx1 = (b.x + b.w - 1) / GenEx::Graphics::TILE_SIZE;
+    int ty0 = b.y / GenEx::Graphics::TILE_SIZE, ty1 = (b.y + b.h - 1) / GenEx::Graphics::TILE_SIZE;
+    for (int ty = ty0; ty <= ty1; ty++) {
+        for (int tx = tx0; tx <= tx1; tx++) {
+            Uint32 tile = ty * tiles_x + tx;
+            if (bins[tile].empty())
+                busy.push_back(tile);
+            bins[tile].push_back(index);
         }
     }
+}
 
-    SDL_SetRenderDrawColor(target, r, g, b, a);
-    SDL_SetRenderDrawBlendMode(target, blend_mode);
+bool GenEx::Graphics::TileRenderer::draw_sprite(const GenEx::Graphics::Sprite &sprite) {
+    auto found = sources.find(sprite.texture);
+    if (found == sources.end())
+        return false;
+    if (sprite.dst.w <= 0 || sprite.dst.h <= 0 || sprite.color.a == 0)
+        return true;
+
+    Command command;
+    command.type = COMMAND_SPRITE;
+    command.blend = sprite.blend;
+    command.color = sprite.color;
+    command.source = found->second;
+    command.src = sprite.has_src ? sprite.src :
+                  SDL_Rect{ 0, 0, command.source->w, command.source->h };
+    SDL_Rect whole = { 0, 0, command.source->w, command.source->h };
+    SDL_Rect src = command.src;
+    if (!SDL_IntersectRect(&src, &whole, &command.src))
+        return true;
+
+    // inverse of SDL_RenderCopyEx(): undo the turn about dst's centre, then the flips, then
+    // scale into the source rectangle
+    double radians = GenEx::Math::DegreesToRadians(sprite.rotation);
+    float c = (float)std::cos(radians), s = (float)std::sin(radians);
+    float hw = sprite.dst.w / 2.f, hh = sprite.dst.h / 2.f;
+    float cx = sprite.dst.x + hw, cy = sprite.dst.y + hh;
+    float kx = (float)src.w / sprite.dst.w, ky = (float)src.h / sprite.dst.h;
+    float fh = (sprite.flip & SDL_FLIP_HORIZONTAL) ? -1.f : 1.f;
+    float fv = (sprite.flip & SDL_FLIP_VERTICAL) ? -1.f : 1.f;
+    float px = 0.5f - cx, py = 0.5f - cy; // pixel (0, 0)'s centre relative to dst's
+    command.m[0] = kx * fh * c;
+    command.m[1] = kx * fh * s;
+    command.m[2] = src.x + kx * (hw + fh * (c * px + s * py));
+    command.m[3] = -ky * fv * s;
+    command.m[4] = ky * fv * c;
+    command.m[5] = src.y + ky * (hh + fv * (-s * px + c * py));
+
+    float ex = std::fabs(c) * std::fabs(hw) + std::fabs(s) * std::fabs(hh);
+    float ey = std::fabs(s) * std::fabs(hw) + std::fabs(c) * std::fabs(hh);
+    SDL_Rect box = { (int)std::floor(cx - ex), (int)std::floor(cy - ey), 0, 0 };
+    box.w = (int)std::ceil(cx + ex) - box.x;
+    box.h = (int)std::ceil(cy + ey) - box.y;
+    SDL_Rect screen = { 0, 0, target->w, target->h };
+    if (SDL_IntersectRect(&box, &screen, &command.bounds))
+        bin(command);
+    return true;
 }
 
-template <typename T>
-void GenEx::Graphics::RenderLines(SDL_Renderer *target, SDL_Color color,
-                                  std::vector< Math::Vector<2,T> > &pts, float wd) {
-    if (pts.size() < 2)
-        return;
+void GenEx::Graphics::TileRenderer::fill_rect(const SDL_Rect &rect, SDL_Color color,
+                                              SDL_BlendMode blend) {
+    Command command;
+    command.type = COMMAND_FILL;
+    command.blend = blend == SDL_BLENDMODE_NONE ? blend : SDL_BLENDMODE_BLEND;
+    command.color = color;
+
+    SDL_Rect screen = { 0, 0, target->w, target->h };
+    if (SDL_IntersectRect(&rect, &screen, &command.bounds))
+        bin(command);
+}
 
-    for (auto iter = pts.begin(); iter != pts.end() - 1; iter++) {
-        GenEx::Math::Vector<2,T> pt0 = *iter;
-        GenEx::Math::Vector<2,T> pt1 = *(iter+1);
+void GenEx::Graphics::TileRenderer::draw_pixels(const Uint32 *pixels, int stride,
+                                                const SDL_Rect &rect) {
+    Command command;
+    command.type = COMMAND_PIXELS;
+    command.blend = SDL_BLENDMODE_BLEND;
 
-        int x0, y0, x1, y1;
-        x0 = std::round(pt0[0]);
-        x1 = std::round(pt1[0]);
-        y0 = std::round(pt0[1]);
-        y1 = std::round(pt1[1]);
+    SDL_Rect screen = { 0, 0, target->w, target->h };
+    if (!SDL_IntersectRect(&rect, &screen, &command.bounds))
+        return;
 
-        GenEx::Graphics::RenderLine(target, color, x0, y0, x1, y1, wd);
+    // the caller reuses its buffer, so keep our own copy until the flush
+    const SDL_Rect &b = command.bounds;
+    command.offset = layers.size();
+    layers.resize(layers.size() + (size_t)b.w * b.h);
+    for (int y = 0; y < b.h; y++) {
+        const Uint32 *row = pixels + (size_t)(b.y - rect.y + y) * stride + (b.x - rect.x);
+        std::copy(row, row + b.w, &layers[command.offset + (size_t)y * b.w]);
     }
+    bin(command);
 }
 
-template <typename T>
-void GenEx::Graphics::RenderBezier(GenEx::Math::Bezier<T> bezier, SDL_Renderer *target,
-                                   SDL_Color color, float thickness, unsigned int samples) {
-    std::vector< Math::Vector<2,T> > pts;
-    bezier.sample(pts, samples);
+void GenEx::Graphics::TileRenderer::rasterize(size_t tile) {
+    SDL_Rect area = { (int)(tile % tiles_x) * GenEx::Graphics::TILE_SIZE,
+                      (int)(tile / tiles_x) * GenEx::Graphics::TILE_SIZE,
+                      GenEx::Graphics::TILE_SIZE, GenEx::Graphics::TILE_SIZE };
+    Uint32 row[GenEx::Graphics::TILE_SIZE];
+
+    for (Uint32 index : bins[tile]) {
+        const Command &command = commands[index];
+        SDL_Rect span;
+        SDL_IntersectRect(&area, &command.bounds, &span);
+
+        if (command.type == COMMAND_FILL) {
+            Uint32 pixel = (Uint32)command.color.a << 24 | (Uint32)command.color.r << 16 |
+                           (Uint32)command.color.g << 8 | command.color.b;
+            std::fill(row, row + span.w, pixel);
+        }
 
-    GenEx::Graphics::RenderLines(target, color, pts, thickness);
+        for (int y = span.y; y < span.y + span.h; y++) {
+            Uint32 *dst = (Uint32*)((Uint8*)target->pixels + y * target->pitch) + span.x;
+            const Uint32 *src = row;
+            int first = 0, count = span.w;
+
+            if (command.type == COMMAND_PIXELS) {
+                const SDL_Rect &b = command.bounds;
+                src = &layers[command.offset + (size_t)(y - b.y) * b.w + (span.x - b.x)];
+            }
+            else if (command.type == COMMAND_SPRITE) {
+                // nearest texel, like SDL's software renderer; off the source is transparent
+                const SDL_Surface *surf = command.source;
+                const SDL_Rect &clip = command.src;
+                const float *m = command.m;
+                bool modulate = command.color.r != 255 || command.color.g != 255 ||
+                                command.color.b != 255 || command.color.a != 255;
+                float u = m[0] * span.x + m[1] * y + m[2];
+                float v = m[3] * span.x + m[4] * y + m[5];
+
+                if (m[0] == 1.f && m[1] == 0.f && m[3] == 0.f) {
+                    // unscaled & upright: the row's texels are already side by side
+                    int tu = (int)std::floor(u), tv = (int)std::floor(v);
+                    if (tv < clip.y || tv >= clip.y + clip.h)
+                        continue;
+                    first = std::max(clip.x - tu, 0);
+                    count = std::min(clip.x + clip.w - tu, span.w) - first;
+                    if (count <= 0)
+                        continue;
+
+                    src = (const Uint32*)((const Uint8*)surf->pixels + tv * surf->pitch) + tu;
+                    if (modulate) {
+                        for (int x = first; x < first + count; x++)
+                            row[x] = Modulate(src[x], command.color);
+                        src = row;
+                    }
+                }
+                else {
+                    for (int x = 0; x < span.w; x++, u += m[0], v += m[3]) {
+                        int tu = (int)std::floor(u), tv = (int)std::floor(v);
+                        if (tu < clip.x || tv < clip.y || tu >= clip.x + clip.w ||
+                                tv >= clip.y + clip.h) {
+                            row[x] = 0;
+                            continue;
+                        }
+                        Uint32 texel = ((const Uint32*)((const Uint8*)surf->pixels +
+                                                        tv * surf->pitch))[tu];
+                        row[x] = modulate ? Modulate(texel, command.color) : texel;
+                    }
+                }
+            }
+
+            if (command.blend == SDL_BLENDMODE_BLEND)
+                BlendSpan(dst + first, src + first, count);
+            else
+                BlendSpanSlow(dst + first, src + first, count, command.blend);
+        }
+    }
 }
 
-template <typename T>
-void GenEx::Graphics::RenderPath(GenEx::Math::Path<T> &path, SDL_Renderer *target,
-                                 SDL_Color color, float thickness) {
-    std::vector< Math::Vector<2,T> > pts;
-    path.sample(pts);
+void GenEx::Graphics::TileRenderer::flush() {
+    if (commands.empty())
+        return;
 
-    GenEx::Graphics::RenderLines(target, color, pts, thickness);
+    // tiles don't share pixels, so each can run its commands in order on any thread
+    SDL_LockSurface(target);
+    GenEx::Thread::GetJobPool().parallel_for(busy.size(), 1, [this](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            rasterize(busy[i]);
+    });
+    SDL_UnlockSurface(target);
+
+    for (Uint32 tile : busy)
+        bins[tile].clear();
+    busy.clear();
+    commands.clear();
+    layers.clear();
 }
 
+size_t GenEx::Graphics::TileRenderer::size() { return commands.size(); }
+
 // --- WINDOW CLASS -------------------------------------------------------------------------------
 // ------ CONSTRUCTORS ----------------------------------------------------------------------------
 
 GenEx::Graphics::Window::Window(GenEx::Events::EventHandlers evt_handlers,
                                 GenEx::Graphics::WindowData dt) : Layer(evt_handlers) {
     initdata = dt;
-
-    window = SDL_CreateWindow(dt.title.c_str(), dt.x, dt.y, dt.w, dt.h, dt.winflags);
-    renderer = SDL_CreateRenderer(window, -1, dt.renflags);
-
-    if (dt.winflags & SDL_WINDOW_OPENGL) {
-        SDL_GL_CreateContext(window);
-    }
-    else if (dt.winflags & SDL_WINDOW_VULKAN) {
-
-    }
-
-    SDL_SetWindowTitle(window, dt.title.c_str());
-    t_prev = GenEx::Time::GetTime();
+    open(dt, dt.title);
+    set_tickrate(dt.tickrate);
+    subscribe(GenEx::Events::MASK_WINDOWEVENT); // windowevent() is overridden to catch closes
 }
 
 GenEx::Graphics::Window::Window(WindowData dt) : Window(GenEx::Events::GenerateEventHandlerStruct(),
@@ -217,20 +1836,15 @@ GenEx::Graphics::Window::Window(const GenEx::Graphics::Window &other,
     objects = other.objects;
     id_map = other.id_map;
 
-    SDL_GetWindowSize(other.window, &dt.w, &dt.h);
-    window = SDL_CreateWindow(SDL_GetWindowTitle(other.window), dt.x, dt.y, dt.w, dt.h,
-                              dt.winflags);
-    renderer = SDL_CreateRenderer(window, -1, dt.renflags);
-
-    if (dt.winflags & SDL_WINDOW_OPENGL) {
-        SDL_GL_CreateContext(window);
-    }
-    else if (dt.winflags & SDL_WINDOW_VULKAN) {
-
+    if (other.window)
+        SDL_GetWindowSize(other.window, &dt.w, &dt.h);
+    else if (other.surface) {
+        dt.w = other.surface->w;
+        dt.h = other.surface->h;
     }
-
-    SDL_SetWindowTitle(window, dt.title.c_str());
-    t_prev = GenEx::Time::GetTime();
+    open(dt, dt.title);
+    set_tickrate(dt.tickrate);
+    batching = other.batching;
 }
 
 GenEx::Graphics::Window::Window(const GenEx::Graphics::Window &other) : Layer(other) {
@@ -238,19 +1852,9 @@ GenEx::Graphics::Window::Window(const GenEx::Graphics::Window &other) : Layer(ot
     objects = other.objects;
     id_map = other.id_map;
 
-    window = SDL_CreateWindow(SDL_GetWindowTitle(other.window), initdata.x, initdata.y,
-                              initdata.w, initdata.h, initdata.winflags);
-    renderer = SDL_CreateRenderer(window, -1, initdata.renflags);
-
-    if (initdata.winflags & SDL_WINDOW_OPENGL) {
-        SDL_GL_CreateContext(window);
-    }
-    else if (initdata.winflags & SDL_WINDOW_VULKAN) {
-
-    }
-
-    SDL_SetWindowTitle(window, initdata.title.c_str());
-    t_prev = GenEx::Time::GetTime();
+    open(initdata, initdata.title);
+    tickrate = other.tickrate;
+    batching = other.batching;
 }
 
 GenEx::Graphics::Window::Window(GenEx::Graphics::Window &&other) : Layer(other) {
@@ -259,9 +1863,56 @@ GenEx::Graphics::Window::Window(GenEx::Graphics::Window &&other) : Layer(other)
     window     = std::move(other.window);
     renderer   = std::move(other.renderer);
     gl_context = std::move(other.gl_context);
+    surface    = std::move(other.surface);
+    headless_id = other.headless_id;
+    batch      = std::move(other.batch);
+    textures   = std::move(other.textures);
+    lines      = std::move(other.lines);
+    tiles      = std::move(other.tiles);
+    initdata   = std::move(other.initdata);
+
+    tickrate    = other.tickrate;
+    frame_count = other.frame_count;
+    batching    = other.batching;
+}
+
+void GenEx::Graphics::Window::open(const GenEx::Graphics::WindowData &dt, std::string title) {
+    if (dt.headless || dt.backend == BACKEND_TILES) {
+        // the software renderer draws straight into our own surface; with BACKEND_TILES it
+        // only handles what the tile renderer can't
+        surface = SDL_CreateRGBSurfaceWithFormat(0, dt.w, dt.h, 32, SDL_PIXELFORMAT_ARGB8888);
+        renderer = SDL_CreateSoftwareRenderer(surface);
+        if (dt.backend == BACKEND_TILES)
+            tiles.reset(new TileRenderer(renderer, surface));
+        batch.reset(new SpriteBatch(renderer));
+        textures.reset(new TextureCache(renderer));
+        lines.reset(new LineRasterizer(renderer));
+        if (dt.headless) {
+            static std::atomic<Uint32> headless_count(0);
+            headless_id = HEADLESS_WINDOW_ID_BASE + headless_count++;
+            return;
+        }
+
+        // frames are copied on to the window's own surface in render()
+        window = SDL_CreateWindow(title.c_str(), dt.x, dt.y, dt.w, dt.h,
+                                  dt.winflags & ~(SDL_WINDOW_OPENGL | SDL_WINDOW_VULKAN));
+        return;
+    }
+
+    window = SDL_CreateWindow(title.c_str(), dt.x, dt.y, dt.w, dt.h, dt.winflags);
+    renderer = SDL_CreateRenderer(window, -1, dt.renflags);
+    batch.reset(new SpriteBatch(renderer));
+    textures.reset(new TextureCache(renderer));
+    lines.reset(new LineRasterizer(renderer));
+
+    if (dt.winflags & SDL_WINDOW_OPENGL) {
+        SDL_GL_CreateContext(window);
+    }
+    else if (dt.winflags & SDL_WINDOW_VULKAN) {
+
+    }
 
-    t_elapsed  = std::move(other.t_elapsed);
-    t_prev     = std::move(other.t_prev);
+    SDL_SetWindowTitle(window, title.c_str());
 }
 
 // ------ 3D ACCELERATION-RELATED FUNCTIONS -------------------------------------------------------
@@ -323,9 +1974,17 @@ void GenEx::Graphics::Window::set_fullscreen(Uint32 fullscreen) {
     SDL_SetWindowFullscreen(window, fullscreen);
 }
 
+void GenEx::Graphics::Window::set_tickrate(double tickrate) {
+    this->tickrate = (tickrate > 0.0) ? tickrate : GenEx::Graphics::DEFAULT_TICKRATE;
+}
+
+void GenEx::Graphics::Window::set_batching(bool batching) { this->batching = batching; }
+
 // ------ WINDOW PROPERTY GETTERS -----------------------------------------------------------------
 
-Uint32 GenEx::Graphics::Window::get_window_id() { return SDL_GetWindowID(window); }
+Uint32 GenEx::Graphics::Window::get_window_id() {
+    return window ? SDL_GetWindowID(window) : headless_id;
+}
 
 int GenEx::Graphics::Window::get_display_index() { return SDL_GetWindowDisplayIndex(window); }
 
@@ -371,31 +2030,78 @@ float GenEx::Graphics::Window::get_opacity() {
     return opacity;
 }
 
+double GenEx::Graphics::Window::get_tickrate() { return tickrate; }
+
+bool GenEx::Graphics::Window::is_batching() { return batching; }
+
+bool GenEx::Graphics::Window::is_headless() { return surface != nullptr && window == nullptr; }
+
+SDL_Surface *GenEx::Graphics::Window::get_surface() { return surface; }
+
+GenEx::Graphics::TextureCache *GenEx::Graphics::Window::get_texture_cache() {
+    return textures.get();
+}
+
+Uint64 GenEx::Graphics::Window::get_frame_count() { return frame_count; }
+
+Uint64 GenEx::Graphics::Window::get_max_frames() { return initdata.max_frames; }
+
 // ------ WINDOW EVENT HANDLERS -------------------------------------------------------------------
 
 void GenEx::Graphics::Window::destroy() {
     if (!is_dead()) {
         Layer::destroy();
         SDL_GL_DeleteContext(gl_context);
+        batch.reset();
+        textures.reset();
+        lines.reset();
+        tiles.reset();
         SDL_DestroyRenderer(renderer);
-        SDL_DestroyWindow(window);
+        if (window)
+            SDL_DestroyWindow(window);
+        if (surface)
+            SDL_FreeSurface(surface);
     }
 }
 
 void GenEx::Graphics::Window::render(SDL_Renderer *target, int offset_x, int offset_y,
                                      int offset_z) {
     SDL_RenderClear(renderer);
+    if (batching)
+        batch->begin();
+    if (lines)
+        lines->begin();
     Layer::render(this->renderer, offset_x, offset_y, offset_z);
+    if (lines)
+        lines->end();
+    if (batching)
+        batch->end();
+    if (tiles)
+        tiles->flush();
     SDL_RenderPresent(renderer);
-}
+    if (textures)
+        textures->sweep();
+
+    if (tiles && window) {
+        // the surface keeps the size the window was created with; stretch it to fit
+        SDL_Surface *screen = SDL_GetWindowSurface(window);
+        if (screen != nullptr) {
+            SDL_BlitScaled(surface, nullptr, screen, nullptr);
+            SDL_UpdateWindowSurface(window);
+        }
+    }
 
-bool GenEx::Graphics::Window::update(double elapsed) {
-    t_elapsed = GenEx::Time::GetTime() - t_prev;
-    bool ret_val = Layer::update(t_elapsed);
-    t_prev = GenEx::Time::GetTime();
-    return ret_val;
+    if (is_headless() && !initdata.frame_dump.empty()) {
+        char path[1024];
+        SDL_snprintf(path, sizeof(path), initdata.frame_dump.c_str(),
+                     (unsigned long long)frame_count);
+        SDL_SaveBMP(surface, path);
+    }
+    frame_count++;
 }
 
+bool GenEx::Graphics::Window::update(double elapsed) { return Layer::update(elapsed); }
+
 bool GenEx::Graphics::Window::windowevent(Uint8 event, Sint32 data1, Sint32 data2) {
     switch (event) {
     case SDL_WINDOWEVENT_CLOSE:
@@ -411,6 +2117,21 @@ bool GenEx::Graphics::Window::handle_event(SDL_Event &event) {
 
     //SDL_Log("Handling event: %s\n", Debug::GetEventString(event).c_str());
 
+    // touch coordinates are normalized; hit-testing needs them in pixels
+    if (event.type == SDL_FINGERDOWN || event.type == SDL_FINGERUP ||
+            event.type == SDL_FINGERMOTION) {
+        int w = 0, h = 0;
+        SDL_RenderGetLogicalSize(renderer, &w, &h);
+        if ((w == 0 || h == 0) && window != nullptr)
+            SDL_GetWindowSize(window, &w, &h);
+        else if ((w == 0 || h == 0) && surface != nullptr) {
+            // headless windows only have the surface they draw into
+            w = surface->w;
+            h = surface->h;
+        }
+        SetViewportSize(w, h);
+    }
+
     switch (event.type) {
     case SDL_QUIT:
     case SDL_APP_TERMINATING:
@@ -418,6 +2139,9 @@ bool GenEx::Graphics::Window::handle_event(SDL_Event &event) {
 
     case SDL_RENDER_DEVICE_RESET:
     case SDL_RENDER_TARGETS_RESET:
+        // cached textures may have lost their contents along with the targets
+        if (textures)
+            textures->clear();
         return targetreset();
 
     case SDL_WINDOWEVENT:
@@ -531,31 +2255,57 @@ bool GenEx::Graphics::Window::handle_event(SDL_Event &event) {
 
 // --- WINDOW THREAD MANAGEMENT VARS & FUNCTIONS --------------------------------------------------
 
+GenEx::Graphics::WindowThreadData::WindowThreadData(std::string name, Window *window,
+                                                    double framerate) : name(name),
+                                                                        window(window),
+                                                                        framerate(framerate),
+                                                                        complete(false) { }
+
 int GenEx::Graphics::RunWindow(void *data) {
     GenEx::Graphics::WindowThreadData *windt = (GenEx::Graphics::WindowThreadData*)data;
     GenEx::Graphics::Window *win = windt->window;
 
     bool running = true;
+    double t_prev = GenEx::Time::GetTime();
+    double t_start = t_prev;
+    double accumulator = 0.0;
 
     while (running) {
-        win->render(nullptr, 0, 0, 0);
-        running &= win->update(0);
+        double now = GenEx::Time::GetTime();
+        accumulator += std::min(now - t_prev, GenEx::Graphics::MAX_FRAME_TIME);
+        t_prev = now;
+
+        // simulate in fixed steps no matter how long the last frame took
+        double step = 1.0 / win->get_tickrate();
+        while (running && accumulator >= step) {
+            running &= win->update(step);
+            accumulator -= step;
+        }
 
         if (running) {
-            // wait for signal from main thread to access event buffer
-            SDL_CondWait(windt->c, windt->m);
+            // draw objects part of the way between their last two steps
+            GenEx::Object::SetInterpolation(accumulator / step);
+            win->render(nullptr, 0, 0, 0);
+
+            if (win->get_max_frames() && win->get_frame_count() >= win->get_max_frames())
+                running = false;
 
-            std::vector<SDL_Event> event_buffer(windt->event_buffer);
-            windt->event_buffer.clear();
+            // park until the main thread hands over this frame's events
+            windt->events.wait();
 
-            for (auto &event : event_buffer) {
+            SDL_Event event;
+            while (running && windt->events.pop(event))
                 running &= win->handle_event(event);
-                if (!running)
-                    break;
-            }
         }
     }
 
+    if (win->is_headless()) {
+        double t_total = GenEx::Time::GetTime() - t_start;
+        SDL_Log("%s: %llu frames in %.3fs (%.1f fps)\n", windt->name.c_str(),
+                (unsigned long long)win->get_frame_count(), t_total,
+                t_total > 0.0 ? win->get_frame_count() / t_total : 0.0);
+    }
+
     windt->complete = true;
     return 0;
 }
@@ -566,22 +2316,221 @@ GenEx::Graphics::WindowThreadData *GenEx::Graphics::CreateWindow(
     GenEx::Graphics::Window *win = new GenEx::Graphics::Window(evt_handlers, windt);
     std::string th_name = "win" + std::to_string((int)win->get_id());
 
-    GenEx::Graphics::WindowThreadData *winthdt = new GenEx::Graphics::WindowThreadData {
-        th_name,
-        win,
-        SDL_CreateCond(),
-        SDL_CreateMutex(),
-        std::vector<SDL_Event>(),
-        windt.framerate,
-        false
-    };
+    GenEx::Graphics::WindowThreadData *winthdt = new GenEx::Graphics::WindowThreadData(
+        th_name, win, windt.framerate
+    );
     SDL_CreateThread(GenEx::Graphics::RunWindow, th_name.c_str(), (void*)(winthdt));
     return winthdt;
 }
 
 GenEx::Graphics::WindowThreadData *GenEx::Graphics::CreateWindow(
         std::string title, int x, int y, int w, int h, Uint32 winflags, Uint32 renflags,
-        GenEx::Events::EventHandlers evt_handlers, double framerate) {
-    WindowData windt = { title, x, y, w, h, winflags, renflags, framerate };
+        GenEx::Events::EventHandlers evt_handlers, double framerate, double tickrate) {
+    WindowData windt = { title, x, y, w, h, winflags, renflags, framerate, tickrate };
     return GenEx::Graphics::CreateWindow(windt, evt_handlers);
 }
+
+// --- WINDOW EVENT ROUTING -----------------------------------------------------------------------
+
+Uint32 GenEx::Graphics::EventRouter::GetEventWindowID(const SDL_Event &event) {
+    switch (event.type) {
+    case SDL_WINDOWEVENT:
+        return event.window.windowID;
+
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+        return event.key.windowID;
+
+    case SDL_TEXTEDITING:
+        return event.edit.windowID;
+    case SDL_TEXTINPUT:
+        return event.text.windowID;
+
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+        return event.button.windowID;
+    case SDL_MOUSEMOTION:
+        return event.motion.windowID;
+    case SDL_MOUSEWHEEL:
+        return event.wheel.windowID;
+
+    case SDL_DROPFILE:
+    case SDL_DROPTEXT:
+    case SDL_DROPBEGIN:
+    case SDL_DROPCOMPLETE:
+        return event.drop.windowID;
+
+    default:
+        return 0;
+    }
+}
+
+void GenEx::Graphics::EventRouter::SetEventWindowID(SDL_Event &event, Uint32 window_id) {
+    switch (event.type) {
+    case SDL_WINDOWEVENT:
+        event.window.windowID = window_id;
+        break;
+
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+        event.key.windowID = window_id;
+        break;
+
+    case SDL_TEXTEDITING:
+        event.edit.windowID = window_id;
+        break;
+    case SDL_TEXTINPUT:
+        event.text.windowID = window_id;
+        break;
+
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+        event.button.windowID = window_id;
+        break;
+    case SDL_MOUSEMOTION:
+        event.motion.windowID = window_id;
+        break;
+    case SDL_MOUSEWHEEL:
+        event.wheel.windowID = window_id;
+        break;
+
+    case SDL_DROPFILE:
+    case SDL_DROPTEXT:
+    case SDL_DROPBEGIN:
+    case SDL_DROPCOMPLETE:
+        event.drop.windowID = window_id;
+        break;
+
+    default:
+        break;
+    }
+}
+
+bool GenEx::Graphics::EventRouter::CoalesceEvents(SDL_Event &into, const SDL_Event &next) {
+    if (into.type != next.type)
+        return false;
+
+    switch (next.type) {
+    case SDL_MOUSEMOTION:
+        if (into.motion.windowID != next.motion.windowID || into.motion.which != next.motion.which
+                || into.motion.state != next.motion.state)
+            return false;
+        into.motion.x = next.motion.x;
+        into.motion.y = next.motion.y;
+        into.motion.xrel += next.motion.xrel;
+        into.motion.yrel += next.motion.yrel;
+        break;
+
+    case SDL_FINGERMOTION:
+        if (into.tfinger.touchId != next.tfinger.touchId ||
+                into.tfinger.fingerId != next.tfinger.fingerId)
+            return false;
+        into.tfinger.x = next.tfinger.x;
+        into.tfinger.y = next.tfinger.y;
+        into.tfinger.dx += next.tfinger.dx;
+        into.tfinger.dy += next.tfinger.dy;
+        into.tfinger.pressure = next.tfinger.pressure;
+        break;
+
+    case SDL_JOYAXISMOTION:
+        if (into.jaxis.which != next.jaxis.which || into.jaxis.axis != next.jaxis.axis)
+            return false;
+        into.jaxis.value = next.jaxis.value;
+        break;
+
+    case SDL_CONTROLLERAXISMOTION:
+        if (into.caxis.which != next.caxis.which || into.caxis.axis != next.caxis.axis)
+            return false;
+        into.caxis.value = next.caxis.value;
+        break;
+
+    default:
+        return false;
+    }
+
+    into.common.timestamp = next.common.timestamp;
+    return true;
+}
+
+int GenEx::Graphics::EventRouter::get_slot(Uint32 window_id) const {
+    const std::vector<int> &table = (window_id >= HEADLESS_WINDOW_ID_BASE) ?
+                                    headless_slot_table : slot_table;
+    Uint32 index = (window_id >= HEADLESS_WINDOW_ID_BASE) ? window_id - HEADLESS_WINDOW_ID_BASE
+                                                          : window_id;
+    if (index >= table.size())
+        return -1;
+    return table[index];
+}
+
+void GenEx::Graphics::EventRouter::set_slot(Uint32 window_id, int slot) {
+    std::vector<int> &table = (window_id >= HEADLESS_WINDOW_ID_BASE) ?
+                              headless_slot_table : slot_table;
+    Uint32 index = (window_id >= HEADLESS_WINDOW_ID_BASE) ? window_id - HEADLESS_WINDOW_ID_BASE
+                                                          : window_id;
+    if (index >= table.size())
+        table.resize(index + 1, -1);
+    table[index] = slot;
+}
+
+void GenEx::Graphics::EventRouter::add_window(Uint32 window_id) {
+    if (window_id == 0 || get_slot(window_id) >= 0)
+        return;
+
+    int slot;
+    if (!free_slots.empty()) {
+        slot = free_slots.back();
+        free_slots.pop_back();
+    }
+    else {
+        slot = buckets.size();
+        buckets.emplace_back();
+    }
+
+    buckets[slot].events.clear();
+    buckets[slot].global_cursor = next_seq;
+    buckets[slot].active = true;
+    set_slot(window_id, slot);
+}
+
+void GenEx::Graphics::EventRouter::remove_window(Uint32 window_id) {
+    int slot = get_slot(window_id);
+    if (slot < 0)
+        return;
+
+    buckets[slot].events.clear();
+    buckets[slot].active = false;
+    free_slots.push_back(slot);
+    set_slot(window_id, -1);
+}
+
+void GenEx::Graphics::EventRouter::route(const SDL_Event &event) {
+    Uint32 window_id = GetEventWindowID(event);
+
+    // events without a window (or without keyboard/mouse focus) go to everyone
+    if (window_id == 0) {
+        global_lane.push_back(RoutedEvent{ next_seq++, event });
+        return;
+    }
+
+    int slot = get_slot(window_id);
+    if (slot >= 0)
+        buckets[slot].events.push_back(RoutedEvent{ next_seq++, event });
+}
+
+void GenEx::Graphics::EventRouter::set_coalescing(bool coalescing) {
+    this->coalescing = coalescing;
+}
+
+bool GenEx::Graphics::EventRouter::is_coalescing() const { return coalescing; }
+
+void GenEx::Graphics::EventRouter::trim() {
+    Uint64 low = next_seq;
+    for (auto &bucket : buckets)
+        if (bucket.active && bucket.global_cursor < low)
+            low = bucket.global_cursor;
+
+    auto iter = global_lane.begin();
+    while (iter != global_lane.end() && iter->seq < low)
+        iter++;
+    global_lane.erase(global_lane.begin(), iter);
+}
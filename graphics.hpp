@@ -30,7 +30,12 @@
 
 #include "base.hpp"
 #include "math.hpp"
+#include "graphics/atlas.hpp"
+#include "graphics/batch.hpp"
 #include "graphics/draw.hpp"
+#include "graphics/lines.hpp"
+#include "graphics/texcache.hpp"
+#include "graphics/tiles.hpp"
 #include "graphics/window.hpp"
 
 #endif // GRAPHICS_HPP
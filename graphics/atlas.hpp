@@ -0,0 +1,266 @@
+/**
+ * \file atlas.hpp
+ *
+ * \author Simon Struthers <snstruthers@gmail.com>
+ * \version pre_dev v0.1.0
+ *
+ * \section LICENSE
+ * GenEx (short for General Executor) - window manager and runtime environment.
+ * Copyright (C) 2019 | The GenEx Project
+ *
+ * This file is part of GenEx.
+ *
+ * GenEx is free software: you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License version 2 as published by the Free Software Foundation.
+ *
+ * GenEx is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at https://www.gnu.org/copyleft/gpl.html
+ *
+ * You should have received a copy of the GNU General Public License version 2 along with GenEx.
+ * If not, see http://www.gnu.org/licenses.
+ *
+ * \section DESCRIPTION
+ * The header file for packing many small images into a few large textures.
+ *
+ */
+
+#ifndef GRAPHICS_ATLAS_HPP
+#define GRAPHICS_ATLAS_HPP
+
+#include "base.hpp"
+#include "util/slotmap.hpp"
+
+namespace GenEx {
+    namespace Graphics {
+
+// --- SKYLINE PACKER -----------------------------------------------------------------------------
+
+        /** \brief Places rectangles in a fixed-size area, bottom-left first, by tracking the
+         *        top edge ("skyline") of everything placed so far. Space can't be freed
+         *        one rectangle at a time; clear() & place everything again instead.
+         */
+        class SkylinePacker {
+        private:
+            struct Segment {
+                int x, y, w; // a flat stretch of skyline at height y
+            };
+
+            int width, height;
+            std::vector<Segment> skyline;
+
+            /** \brief Works out where a rectangle would sit if its left edge started at a
+             *        segment.
+             *
+             * \param size_t <u>index</u>: The segment
+             * \param int <u>w</u>: Width of the rectangle
+             * \param int <u>h</u>: Height of the rectangle
+             * \param int &<u>y</u>: Where to store the top edge it would sit at
+             * \return bool FALSE if it doesn't fit there at all
+             *
+             */
+            bool fit(size_t index, int w, int h, int &y);
+
+        public:
+            /** \brief Creates an empty packer.
+             *
+             * \param int <u>width</u>: Width of the area
+             * \param int <u>height</u>: Height of the area
+             *
+             */
+            SkylinePacker(int width, int height);
+
+            /** \brief Places a rectangle where its bottom edge ends up lowest.
+             *
+             * \param int <u>w</u>: Width of the rectangle
+             * \param int <u>h</u>: Height of the rectangle
+             * \param bool <u>allow_rotate</u>: TRUE to also try it turned 90 degrees
+             * \param SDL_Rect &<u>out</u>: Where to store the placed rectangle; w & h are
+             *        swapped if it was turned
+             * \param bool &<u>rotated</u>: Where to store whether or not it was turned
+             * \return bool FALSE if there's no room left
+             *
+             */
+            bool insert(int w, int h, bool allow_rotate, SDL_Rect &out, bool &rotated);
+
+            /** \brief Forgets every placed rectangle.
+             */
+            void clear();
+        };
+
+// --- TEXTURE ATLAS ------------------------------------------------------------------------------
+
+        /** \brief The default width & height of an atlas page in pixels
+         */
+        const int DEFAULT_ATLAS_SIZE = 2048;
+
+        /** \brief The default share of a page's used area that may be wasted on removed images
+         *        before the atlas repacks instead of opening a new page
+         */
+        const double DEFAULT_REPACK_THRESHOLD = 0.25;
+
+        /** \brief Where an image ended up in an atlas.
+         */
+        struct AtlasRegion {
+            SDL_Texture *texture; // the page holding the image
+            SDL_Rect rect; // pass as RenderImg()'s clipping_rect
+            bool rotated; // stored turned 90 degrees clockwise; rect's w & h are swapped
+        };
+
+        /** \brief Packs images into a few large textures for one renderer, so sprites sharing
+         *        an atlas batch into the same texture run.
+         *
+         * Images are handed out as handles instead of regions because repacking moves them;
+         * look the region up with get() each time it's drawn. The atlas keeps a copy of every
+         * image so it can repack, and a copy of every page if the renderer has a TileRenderer.
+         */
+        class TextureAtlas {
+        private:
+            struct Page {
+                SDL_Texture *texture;
+                SkylinePacker packer;
+                size_t used_area; // area of every cell placed since the last repack
+                size_t live_area; // area of the cells still in use
+                SDL_Surface *mirror; // the page's pixels for a tile renderer; NULLPTR if none
+            };
+
+            struct Entry {
+                SDL_Surface *surface; // our ARGB8888 copy of the image
+                size_t page;
+                AtlasRegion region;
+            };
+
+            SDL_Renderer *renderer;
+            int page_size;
+            int padding;
+            bool allow_rotate;
+            double repack_threshold = DEFAULT_REPACK_THRESHOLD;
+
+            std::vector<Page> pages;
+            Util::SlotMap<Entry> entries;
+
+            bool open_page();
+            void close_page(Page &page);
+            bool place(Entry &entry, size_t first_page);
+            void assign(Entry &entry, size_t page, const SDL_Rect &cell, bool rotated);
+            bool upload(const Entry &entry);
+
+        public:
+            /** \brief Creates an empty atlas; pages are made as they're needed.
+             *
+             * \param SDL_Renderer *<u>renderer</u>: The renderer the pages belong to
+             * \param int <u><i>page_size</i></u>: Width & height of each page; defaults to
+             *        <i>DEFAULT_ATLAS_SIZE</i>
+             * \param int <u><i>padding</i></u>: Transparent pixels kept around each image so
+             *        filtering doesn't bleed neighbours in; defaults to 1
+             * \param bool <u><i>allow_rotate</i></u>: TRUE to let images be stored turned 90
+             *        degrees when that packs better; defaults to FALSE
+             *
+             */
+            TextureAtlas(SDL_Renderer *renderer, int page_size = DEFAULT_ATLAS_SIZE,
+                         int padding = 1, bool allow_rotate = false);
+
+            TextureAtlas(const TextureAtlas &other) = delete;
+            TextureAtlas &operator= (const TextureAtlas &other) = delete;
+
+            /** \brief Destroys every page & image copy.
+             */
+            ~TextureAtlas();
+
+            /** \brief Copies an image into the atlas. Draws already queued for the renderer
+             *        are flushed first, since the upload or a repack may overwrite their pixels.
+             *
+             * \param SDL_Surface *<u>surf</u>: The image; the caller keeps ownership
+             * \return Util::SlotHandle Handle to the image, or <i>Util::NULL_SLOT_HANDLE</i> if
+             *         it's larger than a page or couldn't be uploaded
+             *
+             */
+            Util::SlotHandle add(SDL_Surface *surf);
+
+            /** \brief Takes an image out of the atlas. Its space is reclaimed by the next
+             *        repack, or straight away if its page is left empty.
+             *
+             * \param Util::SlotHandle <u>handle</u>: Handle from add()
+             * \return bool FALSE if the handle was stale
+             *
+             */
+            bool remove(Util::SlotHandle handle);
+
+            /** \brief Gets where an image currently is.
+             *
+             * \param Util::SlotHandle <u>handle</u>: Handle from add()
+             * \return AtlasRegion* The region, or NULLPTR if the handle is stale; only valid
+             *         until the next add(), remove() or repack()
+             *
+             */
+            const AtlasRegion *get(Util::SlotHandle handle);
+
+            /** \brief Places every image again from scratch, most likely moving them, and frees
+             *        pages left empty. Flushes queued draws first, like add(). The new layout is
+             *        worked out in full before anything changes, so if it needs a page that
+             *        can't be made the old one is kept.
+             *
+             * \return bool FALSE if the images were left where they were or one could not be
+             *         uploaded again
+             *
+             */
+            bool repack();
+
+            /** \brief Sets how much removed-image waste makes add() repack before it opens a
+             *        new page.
+             *
+             * \param double <u>threshold</u>: Share of the used area, from 0 to 1
+             *
+             */
+            void set_repack_threshold(double threshold);
+
+            /** \brief Gets the share of the placed area taken up by removed images.
+             *
+             * \return double Wasted area / placed area; 0 if nothing was placed
+             *
+             */
+            double get_fragmentation();
+
+            /** \brief Returns how many pages the atlas uses.
+             *
+             * \return size_t Number of page textures
+             *
+             */
+            size_t num_pages();
+
+            /** \brief Returns how many images are in the atlas.
+             *
+             * \return size_t Number of images
+             *
+             */
+            size_t size();
+        };
+
+        /** \brief Renders an image from an atlas, turning it back upright if it was stored
+         *        rotated. Takes the same placement arguments as RenderImg().
+         *
+         * \param AtlasRegion &<u>region</u>: Where the image is; see TextureAtlas::get()
+         * \param SDL_Renderer *<u>target</u>: The target to render to
+         * \param float <u>x</u>: The X-position of the image
+         * \param float <u>y</u>: The Y-position of the image
+         * \param float <u>offset_x</u>: How much to translate the image on the X-axis
+         * \param float <u>offset_y</u>: How much to translate the image on the Y-axis
+         * \param float <u><i>anchor_x</i></u>: The horizontal anchor; 0.5 by default
+         * \param float <u><i>anchor_y</i></u>: The vertical anchor; 0.5 by default
+         * \param double <u><i>rotation</i></u>: Rotation in degrees; 0 by default
+         * \param float <u><i>scale_x</i></u>: Horizontal scale; 1.0 by default
+         * \param float <u><i>scale_y</i></u>: Vertical scale; 1.0 by default
+         * \param bool <u><i>flip_horizontal</i></u>: Mirror left to right; FALSE by default
+         * \param bool <u><i>flip_vertical</i></u>: Mirror top to bottom; FALSE by default
+         * \return bool TRUE if rendering the image was successful
+         *
+         */
+        bool RenderImg(const AtlasRegion &region, SDL_Renderer *target, float x, float y,
+                       float offset_x, float offset_y, float anchor_x = 0.5f,
+                       float anchor_y = 0.5f, double rotation = 0.0, float scale_x = 1.f,
+                       float scale_y = 1.f, bool flip_horizontal = false,
+                       bool flip_vertical = false);
+    }
+}
+
+#endif // GRAPHICS_ATLAS_HPP
@@ -0,0 +1,189 @@
+/**
+ * \file batch.hpp
+ *
+ * \author Simon Struthers <snstruthers@gmail.com>
+ * \version pre_dev v0.1.0
+ *
+ * \section LICENSE
+ * GenEx (short for General Executor) - window manager and runtime environment.
+ * Copyright (C) 2019 | The GenEx Project
+ *
+ * This file is part of GenEx.
+ *
+ * GenEx is free software: you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License version 2 as published by the Free Software Foundation.
+ *
+ * GenEx is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at https://www.gnu.org/copyleft/gpl.html
+ *
+ * You should have received a copy of the GNU General Public License version 2 along with GenEx.
+ * If not, see http://www.gnu.org/licenses.
+ *
+ * \section DESCRIPTION
+ * The header file for batching sprite draws by texture.
+ *
+ */
+
+#ifndef GRAPHICS_BATCH_HPP
+#define GRAPHICS_BATCH_HPP
+
+#include "base.hpp"
+
+namespace GenEx {
+    namespace Graphics {
+
+// --- SPRITES ------------------------------------------------------------------------------------
+
+        /** \brief One textured quad waiting in a SpriteBatch.
+         */
+        struct Sprite {
+            SDL_Texture *texture;
+            SDL_Rect src; // only used if has_src
+            SDL_Rect dst;
+            bool has_src;
+            double rotation; // degrees clockwise around the centre of dst
+            SDL_RendererFlip flip;
+            SDL_Color color; // colour & alpha modulation
+            SDL_BlendMode blend;
+            int layer; // lower layers are always drawn first
+        };
+
+        /** \brief How many runs back a sprite may be moved to join one using its texture, and
+         *        how many sprites of a run are checked for overlap before giving up
+         */
+        const size_t BATCH_LOOKBACK = 32;
+
+// --- SPRITE BATCH CLASS -------------------------------------------------------------------------
+
+        /** \brief Collects the sprite draws for one renderer & submits them grouped by texture.
+         *
+         * While a batch is active on the current thread, RenderImg() calls targeting its
+         * renderer are queued instead of drawn. At flush() the queue is stably ordered by layer;
+         * within a layer a sprite is moved back to join an earlier run with the same texture &
+         * blend mode, but never past a sprite it overlaps, so the picture comes out the same as
+         * drawing in call order. Each run sets its blend mode once and only touches the colour
+         * modulation when it changes.
+         *
+         * Drawing anything else on the renderer (e.g. RenderLine()) flushes first; code calling
+         * SDL directly must call FlushRenderer() first. Queued textures must stay alive until
+         * the batch is flushed.
+         */
+        class SpriteBatch {
+        private:
+            SDL_Renderer *renderer;
+            SDL_Texture *target = nullptr; // render target the queued sprites were drawn for
+
+            std::vector<Sprite> sprites;
+            int layer = 0;
+
+            struct Run {
+                SDL_Texture *texture;
+                SDL_BlendMode blend;
+                SDL_Rect bounds; // union of every member's bounding box
+                size_t first, last; // chained through next
+            };
+            std::vector<Run> runs;
+            std::vector<size_t> next; // sprite index -> next sprite in its run; ~0 to end
+            std::vector<SDL_Rect> boxes; // sprite index -> bounding box
+            std::vector<size_t> order; // sprite indices stably sorted by layer
+
+            // sizes of the textures queued this frame; dropped at end() so a destroyed
+            // texture's address being reused can't pick up a stale size
+            std::unordered_map<SDL_Texture*, SDL_Point> sizes;
+
+            SpriteBatch *previous = nullptr; // batch that was active before begin()
+            bool active = false;
+
+            size_t run_count = 0;
+
+            static thread_local SpriteBatch *current;
+
+            bool overlaps(const Run &run, const SDL_Rect &bounds);
+            void build_runs(size_t begin, size_t end);
+            void submit_runs();
+
+        public:
+            /** \brief Creates an inactive batch for a renderer.
+             *
+             * \param SDL_Renderer *<u>renderer</u>: The renderer sprites will be drawn with
+             *
+             */
+            SpriteBatch(SDL_Renderer *renderer);
+
+            SpriteBatch(const SpriteBatch &other) = delete;
+            SpriteBatch &operator= (const SpriteBatch &other) = delete;
+
+            /** \brief Drops anything still queued; the renderer may already be gone.
+             */
+            ~SpriteBatch();
+
+            /** \brief Gets the batch RenderImg() should queue into for a renderer.
+             *
+             * \param SDL_Renderer *<u>renderer</u>: The renderer being drawn to
+             * \return SpriteBatch* The active batch on this thread for <u>renderer</u>, or
+             *         NULLPTR if draws should go straight through
+             *
+             */
+            static SpriteBatch *GetActive(SDL_Renderer *renderer);
+
+            /** \brief Makes this the active batch on the calling thread.
+             */
+            void begin();
+
+            /** \brief Flushes & makes whichever batch was active before begin() active again.
+             *        Forgets the cached texture sizes.
+             */
+            void end();
+
+            /** \brief Returns whether or not this batch is collecting draws.
+             *
+             * \return bool TRUE between begin() & end()
+             *
+             */
+            bool is_active();
+
+            /** \brief Sets the layer sprites queued from now on go in.
+             *
+             * \param int <u>layer</u>: The layer; lower layers are drawn first
+             *
+             */
+            void set_layer(int layer);
+
+            /** \brief Gets the width & height of a texture, querying SDL only once per frame.
+             *
+             * \param SDL_Texture *<u>texture</u>: The texture
+             * \return SDL_Point The texture's width (x) & height (y)
+             *
+             */
+            SDL_Point get_size(SDL_Texture *texture);
+
+            /** \brief Queues a sprite; fills in its layer from set_layer().
+             *
+             * \param Sprite <u>sprite</u>: The sprite to queue
+             *
+             */
+            void draw(Sprite sprite);
+
+            /** \brief Submits every queued sprite to the renderer.
+             */
+            void flush();
+
+            /** \brief Returns how many sprites are queued.
+             *
+             * \return size_t Number of queued sprites
+             *
+             */
+            size_t size();
+
+            /** \brief Returns how many texture runs the last flush() submitted.
+             *
+             * \return size_t Number of runs
+             *
+             */
+            size_t get_run_count();
+        };
+    }
+}
+
+#endif // GRAPHICS_BATCH_HPP
@@ -30,19 +30,24 @@
 
 #include "base.hpp"
 #include "math.hpp"
+#include "graphics/lines.hpp"
 
 namespace GenEx {
     namespace Graphics {
 // --- RENDERING 2D IMAGES TO A TARGET ------------------------------------------------------------
 
-        /** \brief Renders an SDL_Texture to a target with transformations if wanted.
+        /** \brief Renders an SDL_Texture to a target with transformations if wanted. In a
+         *        window that batches (see Window::set_batching()) the draw is only queued, so
+         *        <u>img</u> must not be destroyed before the frame ends, & anything drawn
+         *        through SDL directly needs a FlushRenderer() first to keep its place.
          *
          * \param SDL_Texture *<u>img</u>: The image to render
          * \param SDL_Renderer *<u>target</u>: The target to render to
          * \param float <u>x</u>: The X-position of the image
          * \param float <u>y</u>: The Y-position of the image
-         * \param SDL_Rect *<u>clipping_rect</u>: Pointer to a clipping box for the image;
-         *        set to <i>nullptr</i> to render the whole image
+         * \param SDL_Rect *<u>clipping_rect</u>: Pointer to a clipping box for the image; it
+         *        is drawn at the box's size times the scale. Set to <i>nullptr</i> to render
+         *        the whole image
          * \param float <u>offset_x</u>: How much to translate the image on the X-axis
          * \param float <u>offset_y</u>: How much to translate the image on the Y-axis
          * \param float <u><i>anchor_x</i></u>: The horizontal anchor for the image; set to 0.5
@@ -68,14 +73,17 @@ namespace GenEx {
                        double rotation = 0.0, float scale_x = 1.f, float scale_y = 1.f,
                        bool flip_horizontal = false, bool flip_vertical = false);
 
-        /** \brief Renders an SDL_Surface to a target with transformations if wanted.
+        /** \brief Renders an SDL_Surface to a target with transformations if wanted. The
+         *        texture comes from the target's TextureCache if it has one; call
+         *        MarkSurfaceChanged() after editing the surface in place.
          *
          * \param SDL_Surface *<u>surf</u>: The image to render
          * \param SDL_Renderer *<u>target</u>: The target to render to
          * \param float <u>x</u>: The X-position of the image
          * \param float <u>y</u>: The Y-position of the image
-         * \param SDL_Rect *<u>clipping_rect</u>: Pointer to a clipping box for the image;
-         *        set to <i>nullptr</i> to render the whole image
+         * \param SDL_Rect *<u>clipping_rect</u>: Pointer to a clipping box for the image; it
+         *        is drawn at the box's size times the scale. Set to <i>nullptr</i> to render
+         *        the whole image
          * \param float <u>offset_x</u>: How much to translate the image on the X-axis
          * \param float <u>offset_y</u>: How much to translate the image on the Y-axis
          * \param float <u><i>anchor_x</i></u>: The horizontal anchor for the image; set to 0.5
@@ -101,9 +109,21 @@ namespace GenEx {
                        double rotation = 0.0, float scale_x = 1.0f, float scale_y = 1.0f,
                        bool flip_horizontal = false, bool flip_vertical = false);
 
+        /** \brief Draws everything GenEx has queued for a target: batched sprites, lines held
+         *        back between LineRasterizer::begin() & end(), and tile work. Call it before
+         *        drawing through SDL directly so the two come out in call order.
+         *
+         * \param SDL_Renderer *<u>target</u>: The target to flush
+         *
+         */
+        void FlushRenderer(SDL_Renderer *target);
+
 // --- PRIMITIVES ---------------------------------------------------------------------------------
 
-        /** \brief Renders an antialiased line to a given target.
+        /** \brief Renders an antialiased line to a given target through its LineRasterizer.
+         *        Targets without one get a temporary rasterizer covering just the line, which
+         *        allocates its buffers & a texture every call; give a renderer that draws
+         *        many lines its own LineRasterizer.
          *
          * \param SDL_Renderer *<u>target</u>: The target to render to
          * \param SDL_Color <u>color</u>: The color to draw the line
@@ -111,13 +131,27 @@ namespace GenEx {
          * \param int <u>y0</u>: The Y-coordinate of the first point
          * \param int <u>x1</u>: The X-coordinate of the second point
          * \param int <u>y1</u>: The Y-coordinate of the second point
-         * \param float <u>wd</u>: The width of the line
+         * \param float <u>wd</u>: The width of the line in pixels; zero or less draws a one
+         *        pixel hairline
+         * \param LineCap <u><i>cap</i></u>: How the ends are drawn; CAP_ROUND by default, which
+         *        covers both end pixels
          *
          */
         void RenderLine(SDL_Renderer *target, SDL_Color color,
-                        int x0, int y0, int x1, int y1, float wd);
+                        int x0, int y0, int x1, int y1, float wd, LineCap cap = CAP_ROUND);
+
+        /** \brief Renders a filled rectangle, alpha blended, to a given target; queued on its
+         *        TileRenderer if it has one.
+         *
+         * \param SDL_Renderer *<u>target</u>: The target to render to
+         * \param SDL_Rect <u>rect</u>: The rectangle to fill
+         * \param SDL_Color <u>color</u>: The color to fill it with
+         *
+         */
+        void RenderFillRect(SDL_Renderer *target, SDL_Rect rect, SDL_Color color);
 
-        /** \brief Renders multiple lines to a given target.
+        /** \brief Renders multiple lines to a given target as one path with round caps &
+         *        joins, through a rasterizer as with RenderLine().
          *
          * \param SDL_Renderer *<u>target</u>: The target to render to
          * \param SDL_Color <u>color</u>: The color to draw the lines
@@ -0,0 +1,204 @@
+/**
+ * \file lines.hpp
+ *
+ * \author Simon Struthers <snstruthers@gmail.com>
+ * \version pre_dev v0.1.0
+ *
+ * \section LICENSE
+ * GenEx (short for General Executor) - window manager and runtime environment.
+ * Copyright (C) 2019 | The GenEx Project
+ *
+ * This file is part of GenEx.
+ *
+ * GenEx is free software: you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License version 2 as published by the Free Software Foundation.
+ *
+ * GenEx is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at https://www.gnu.org/copyleft/gpl.html
+ *
+ * You should have received a copy of the GNU General Public License version 2 along with GenEx.
+ * If not, see http://www.gnu.org/licenses.
+ *
+ * \section DESCRIPTION
+ * The header file for rasterizing antialiased lines on the CPU.
+ *
+ */
+
+#ifndef GRAPHICS_LINES_HPP
+#define GRAPHICS_LINES_HPP
+
+#include "base.hpp"
+
+namespace GenEx {
+    namespace Graphics {
+
+// --- LINE STYLES --------------------------------------------------------------------------------
+
+        /** \brief How the open ends of a line are drawn
+         */
+        enum LineCap {
+            CAP_BUTT,   // stops flat at the end point
+            CAP_ROUND,  // a half disc around the end point
+            CAP_SQUARE  // stops flat half the width past the end point
+        };
+
+        /** \brief How two segments of a path are joined
+         */
+        enum LineJoin {
+            JOIN_MITER, // outer edges extended until they meet; bevelled past the miter limit
+            JOIN_BEVEL, // outer corners cut off straight
+            JOIN_ROUND  // a disc around the shared point
+        };
+
+        /** \brief The default longest a miter may get, as a multiple of the line's half width
+         */
+        const float DEFAULT_MITER_LIMIT = 4.f;
+
+// --- LINE RASTERIZER CLASS ----------------------------------------------------------------------
+
+        /** \brief Rasterizes antialiased lines & paths for one renderer on the CPU & uploads
+         *        them through a single streaming texture.
+         *
+         * Each path is covered analytically pixel by pixel (distance to its edges for
+         * segments, caps & joins) into a coverage buffer, keeping the highest coverage where
+         * pieces overlap, then blended once into a pixel buffer in its colour. Both buffers
+         * are the size of the render target (or of the area given to the constructor) and
+         * reused, so once they're made no path allocates. Outside of begin() & end() every
+         * path is uploaded & drawn as soon as it ends; in between they pile up until end() or
+         * until something else is drawn to the renderer, which flushes them first.
+         */
+        class LineRasterizer {
+        private:
+            SDL_Renderer *renderer;
+            SDL_Texture *texture = nullptr;
+            int width = 0, height = 0; // size of the texture & buffers
+            bool bounded = false; // only draws within <bounds>
+            SDL_Rect bounds = { 0, 0, 0, 0 };
+            int origin_x = 0, origin_y = 0; // where the buffers sit on the target
+
+            std::vector<Uint8> coverage; // the current path
+            std::vector<SDL_Point> spans; // row -> [x, y) of the current path's coverage
+            std::vector<Uint32> pixels; // ARGB8888, not premultiplied
+            SDL_Rect path_dirty = { 0, 0, 0, 0 };
+            SDL_Rect frame_dirty = { 0, 0, 0, 0 };
+            int depth = 0; // begin() nesting
+
+            // the path being built
+            bool path_ok = false;
+            SDL_Color color;
+            float radius; // half the width, at least half a pixel
+            float alpha_scale; // thinner than a pixel fades instead
+            float overlap; // how far pieces of the path reach under each other
+            LineCap cap;
+            LineJoin join;
+            float miter_limit;
+            int num_points = 0;
+            float start_x, start_y, first_ux, first_uy; // first point & direction
+            float last_x, last_y, last_ux, last_uy; // last point & direction
+            float prev_x, prev_y, prev_overlap; // start of the segment ending at the last point
+
+            bool fit_target();
+            void mark(SDL_Rect &dirty, const SDL_Rect &rect);
+            void mark_row(int y, int x, int x_end);
+            void cover_polygon(const float *xy, int n);
+            void cover_capsule(float ax, float ay, float bx, float by, float r);
+            void cover_segment(float back, float front);
+            void cover_cap(float x, float y, float ux, float uy);
+            void cover_join(float x, float y, float u0x, float u0y, float u1x, float u1y);
+            void composite();
+
+        public:
+            /** \brief Creates a rasterizer & makes it the one RenderLine() uses for a
+             *        renderer. Buffers are made on the first path.
+             *
+             * \param SDL_Renderer *<u>renderer</u>: The renderer to draw with
+             *
+             */
+            LineRasterizer(SDL_Renderer *renderer);
+
+            /** \brief Creates a rasterizer that only draws within part of the target, with
+             *        buffers & texture just that big. It isn't registered for the renderer;
+             *        RenderLine() uses one per call on renderers without a rasterizer.
+             *
+             * \param SDL_Renderer *<u>renderer</u>: The renderer to draw with
+             * \param SDL_Rect <u>bounds</u>: The part of the target that may be drawn to
+             *
+             */
+            LineRasterizer(SDL_Renderer *renderer, SDL_Rect bounds);
+
+            LineRasterizer(const LineRasterizer &other) = delete;
+            LineRasterizer &operator= (const LineRasterizer &other) = delete;
+
+            /** \brief Destroys the texture; the renderer must still exist. Anything not yet
+             *        flushed is dropped.
+             */
+            ~LineRasterizer();
+
+            /** \brief Gets the rasterizer RenderLine() should use for a renderer.
+             *
+             * \param SDL_Renderer *<u>renderer</u>: The renderer being drawn to
+             * \return LineRasterizer* The renderer's rasterizer, or NULLPTR if it has none
+             *
+             */
+            static LineRasterizer *Get(SDL_Renderer *renderer);
+
+            /** \brief Holds finished paths back until the matching end(), so they're uploaded
+             *        together. Calls nest.
+             */
+            void begin();
+
+            /** \brief Flushes once the outermost begin() is matched.
+             */
+            void end();
+
+            /** \brief Draws a single segment.
+             *
+             * \param float <u>x0</u>: X-coordinate of the first point
+             * \param float <u>y0</u>: Y-coordinate of the first point
+             * \param float <u>x1</u>: X-coordinate of the second point
+             * \param float <u>y1</u>: Y-coordinate of the second point
+             * \param float <u>width</u>: Width of the line in pixels; see begin_path()
+             * \param SDL_Color <u>color</u>: Colour of the line
+             * \param LineCap <u><i>cap</i></u>: How the ends are drawn; CAP_BUTT by default
+             *
+             */
+            void line(float x0, float y0, float x1, float y1, float width, SDL_Color color,
+                      LineCap cap = CAP_BUTT);
+
+            /** \brief Starts a new path, ending any unfinished one.
+             *
+             * \param float <u>width</u>: Width of the path in pixels; below one pixel the path
+             *        fades instead of thinning, & zero or less draws a one pixel hairline
+             * \param SDL_Color <u>color</u>: Colour of the path
+             * \param LineCap <u><i>cap</i></u>: How the ends are drawn; CAP_BUTT by default
+             * \param LineJoin <u><i>join</i></u>: How segments meet; JOIN_MITER by default
+             * \param float <u><i>miter_limit</i></u>: Longest a miter may get before it's
+             *        bevelled, in half widths; <i>DEFAULT_MITER_LIMIT</i> by default
+             *
+             */
+            void begin_path(float width, SDL_Color color, LineCap cap = CAP_BUTT,
+                            LineJoin join = JOIN_MITER, float miter_limit = DEFAULT_MITER_LIMIT);
+
+            /** \brief Adds a point to the path; the first one only moves the pen. Points
+             *        repeating the previous one are skipped.
+             *
+             * \param float <u>x</u>: X-coordinate; pixel centres are at .5
+             * \param float <u>y</u>: Y-coordinate; pixel centres are at .5
+             *
+             */
+            void line_to(float x, float y);
+
+            /** \brief Draws the ends of the path & blends it in; flushes unless between
+             *        begin() & end().
+             */
+            void end_path();
+
+            /** \brief Uploads & draws every finished path. Queued sprites are drawn first.
+             */
+            void flush();
+        };
+    }
+}
+
+#endif // GRAPHICS_LINES_HPP
@@ -0,0 +1,194 @@
+/**
+ * \file texcache.hpp
+ *
+ * \author Simon Struthers <snstruthers@gmail.com>
+ * \version pre_dev v0.1.0
+ *
+ * \section LICENSE
+ * GenEx (short for General Executor) - window manager and runtime environment.
+ * Copyright (C) 2019 | The GenEx Project
+ *
+ * This file is part of GenEx.
+ *
+ * GenEx is free software: you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License version 2 as published by the Free Software Foundation.
+ *
+ * GenEx is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at https://www.gnu.org/copyleft/gpl.html
+ *
+ * You should have received a copy of the GNU General Public License version 2 along with GenEx.
+ * If not, see http://www.gnu.org/licenses.
+ *
+ * \section DESCRIPTION
+ * The header file for caching the textures made from surfaces.
+ *
+ */
+
+#ifndef GRAPHICS_TEXCACHE_HPP
+#define GRAPHICS_TEXCACHE_HPP
+
+#include "base.hpp"
+
+namespace GenEx {
+    namespace Graphics {
+
+// --- SURFACE VERSIONS ---------------------------------------------------------------------------
+
+        /** \brief Makes every TextureCache upload a surface again on its next draw. Call it
+         *        after editing a surface's pixels, palette or colour key in place; swapping
+         *        its pixel buffer, size or format is noticed without it.
+         *
+         * \param SDL_Surface *<u>surf</u>: The surface
+         *
+         */
+        void MarkSurfaceChanged(SDL_Surface *surf);
+
+// --- TEXTURE CACHE CLASS ------------------------------------------------------------------------
+
+        /** \brief The default amount of texture memory a TextureCache may hold, in bytes
+         */
+        const size_t DEFAULT_TEXTURE_BUDGET = 64 * 1024 * 1024;
+
+        /** \brief Keeps the textures made from surfaces for one renderer, so drawing the same
+         *        surface again doesn't upload it again.
+         *
+         * Entries are keyed by the surface's address & stamped with its pixel pointer, size,
+         * pitch, format & MarkSurfaceChanged() version; a mismatched stamp uploads afresh, so
+         * a hit costs one lookup and never reads the pixels. Each entry holds a reference on
+         * its surface, so the address can't be reused while it's cached; sweep() drops the
+         * entries whose surfaces everyone else has freed. Once the textures go over budget,
+         * the least recently drawn ones are destroyed. Only the thread drawing with the
+         * renderer may use its cache.
+         *
+         * If the renderer has a TileRenderer, each entry also keeps an ARGB8888 copy of the
+         * surface for it to draw from; the copy counts towards the budget.
+         */
+        class TextureCache {
+        private:
+            struct Entry {
+                SDL_Surface *surface;
+                SDL_Texture *texture;
+                void *pixels;
+                int w, h, pitch;
+                Uint32 format;
+                Uint32 version;
+                size_t bytes;
+                SDL_Surface *copy; // ARGB8888 pixels for the tile renderer; NULLPTR if none
+                bool referenced; // holds a reference on surface; false for SDL_DONTFREE ones
+            };
+
+            SDL_Renderer *renderer;
+            size_t budget;
+            size_t usage = 0;
+
+            std::list<Entry> entries; // most recently drawn first
+            std::unordered_map<SDL_Surface*, std::list<Entry>::iterator> lookup;
+
+            size_t hits = 0, misses = 0;
+
+            void release(const Entry &entry);
+            void destroy_entry(std::list<Entry>::iterator it);
+            void evict();
+
+        public:
+            /** \brief Creates an empty cache & makes it the one RenderImg() uses for a
+             *        renderer.
+             *
+             * \param SDL_Renderer *<u>renderer</u>: The renderer textures are made for
+             * \param size_t <u><i>budget</i></u>: Texture memory to stay under in bytes;
+             *        defaults to <i>DEFAULT_TEXTURE_BUDGET</i>
+             *
+             */
+            TextureCache(SDL_Renderer *renderer, size_t budget = DEFAULT_TEXTURE_BUDGET);
+
+            TextureCache(const TextureCache &other) = delete;
+            TextureCache &operator= (const TextureCache &other) = delete;
+
+            /** \brief Destroys every cached texture; the renderer must still exist.
+             */
+            ~TextureCache();
+
+            /** \brief Gets the cache RenderImg() should use for a renderer.
+             *
+             * \param SDL_Renderer *<u>renderer</u>: The renderer being drawn to
+             * \return TextureCache* The renderer's cache, or NULLPTR if it has none
+             *
+             */
+            static TextureCache *Get(SDL_Renderer *renderer);
+
+            /** \brief Gets the texture for a surface, uploading it if it isn't cached or has
+             *        changed. The surface's colour, alpha & blend modes are copied over each
+             *        time.
+             *
+             * \param SDL_Surface *<u>surf</u>: The surface
+             * \return SDL_Texture* The texture, owned by the cache; NULLPTR if it couldn't be
+             *         made
+             *
+             */
+            SDL_Texture *get(SDL_Surface *surf);
+
+            /** \brief Destroys a surface's texture, if it's cached, & drops its
+             *        MarkSurfaceChanged() version.
+             *
+             * \param SDL_Surface *<u>surf</u>: The surface
+             *
+             */
+            void forget(SDL_Surface *surf);
+
+            /** \brief Destroys the textures of surfaces that have been freed by everyone but
+             *        the cache, releasing them for good. Windows call it once a frame.
+             */
+            void sweep();
+
+            /** \brief Destroys every cached texture.
+             */
+            void clear();
+
+            /** \brief Sets how much texture memory the cache may hold, evicting straight away
+             *        if it's now over.
+             *
+             * \param size_t <u>bytes</u>: The budget in bytes
+             *
+             */
+            void set_budget(size_t bytes);
+
+            /** \brief Gets how much texture memory the cache may hold.
+             *
+             * \return size_t The budget in bytes
+             *
+             */
+            size_t get_budget();
+
+            /** \brief Gets roughly how much texture memory the cached textures take up.
+             *
+             * \return size_t Width * height * 4 summed over every texture, in bytes
+             *
+             */
+            size_t get_memory_usage();
+
+            /** \brief Returns how many textures are cached.
+             *
+             * \return size_t Number of textures
+             *
+             */
+            size_t size();
+
+            /** \brief Returns how many get() calls found an up-to-date texture.
+             *
+             * \return size_t Number of hits
+             *
+             */
+            size_t get_hits();
+
+            /** \brief Returns how many get() calls had to upload.
+             *
+             * \return size_t Number of misses
+             *
+             */
+            size_t get_misses();
+        };
+    }
+}
+
+#endif // GRAPHICS_TEXCACHE_HPP
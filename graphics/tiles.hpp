@@ -0,0 +1,178 @@
+/**
+ * \file tiles.hpp
+ *
+ * \author Simon Struthers <snstruthers@gmail.com>
+ * \version pre_dev v0.1.0
+ *
+ * \section LICENSE
+ * GenEx (short for General Executor) - window manager and runtime environment.
+ * Copyright (C) 2019 | The GenEx Project
+ *
+ * This file is part of GenEx.
+ *
+ * GenEx is free software: you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License version 2 as published by the Free Software Foundation.
+ *
+ * GenEx is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at https://www.gnu.org/copyleft/gpl.html
+ *
+ * You should have received a copy of the GNU General Public License version 2 along with GenEx.
+ * If not, see http://www.gnu.org/licenses.
+ *
+ * \section DESCRIPTION
+ * The header file for the multithreaded tile-based software renderer.
+ *
+ */
+
+#ifndef GRAPHICS_TILES_HPP
+#define GRAPHICS_TILES_HPP
+
+#include "base.hpp"
+#include "graphics/batch.hpp"
+
+namespace GenEx {
+    namespace Graphics {
+
+// --- TILE RENDERER CLASS ------------------------------------------------------------------------
+
+        /** \brief The width & height of a TileRenderer tile in pixels
+         */
+        const int TILE_SIZE = 64;
+
+        /** \brief Draws sprites, filled rectangles & line layers into an ARGB8888 surface on
+         *        the CPU, spread over the job pool.
+         *
+         * Draws are recorded as commands & binned into every TILE_SIZE square of the surface
+         * they touch. flush() rasterizes the tiles in parallel, each running its commands in
+         * the order they were given; alpha blending is done four pixels at a time with SSE2
+         * where it's available.
+         *
+         * It sits next to an SDL software renderer drawing into the same surface, so anything
+         * it can't draw (a texture it has no pixels for, or SDL called directly) still works:
+         * flush() first & the picture comes out in order. Textures' pixels are registered
+         * with add_source() by whoever makes them; TextureCache & TextureAtlas do so. Draws
+         * are in surface pixels; the SDL renderer's logical size & scale don't apply.
+         */
+        class TileRenderer {
+        private:
+            enum CommandType {
+                COMMAND_SPRITE,
+                COMMAND_FILL,
+                COMMAND_PIXELS
+            };
+
+            struct Command {
+                CommandType type;
+                SDL_Rect bounds; // clipped to the surface
+                SDL_BlendMode blend;
+                SDL_Color color; // fill colour, or a sprite's colour & alpha modulation
+
+                // sprites: texel = (m0 x + m1 y + m2, m3 x + m4 y + m5) for pixel centre (x, y)
+                const SDL_Surface *source;
+                SDL_Rect src; // the texels that may be sampled
+                float m[6];
+
+                size_t offset; // pixels: where the block starts in <layers>; bounds.w wide
+            };
+
+            SDL_Renderer *renderer;
+            SDL_Surface *target;
+            int tiles_x, tiles_y;
+
+            std::vector<Command> commands;
+            std::vector<std::vector<Uint32>> bins; // tile -> command indices in order
+            std::vector<Uint32> busy; // tiles with at least one command
+            std::vector<Uint32> layers; // copies of pixel blocks
+
+            std::unordered_map<SDL_Texture*, const SDL_Surface*> sources;
+
+            void bin(const Command &command);
+            void rasterize(size_t tile);
+
+        public:
+            /** \brief Creates a renderer for a surface & makes it the one drawing for an SDL
+             *        renderer.
+             *
+             * \param SDL_Renderer *<u>renderer</u>: The SDL software renderer drawing into
+             *        <u>target</u>
+             * \param SDL_Surface *<u>target</u>: The ARGB8888 surface to draw into
+             *
+             */
+            TileRenderer(SDL_Renderer *renderer, SDL_Surface *target);
+
+            TileRenderer(const TileRenderer &other) = delete;
+            TileRenderer &operator= (const TileRenderer &other) = delete;
+
+            /** \brief Drops anything not yet flushed.
+             */
+            ~TileRenderer();
+
+            /** \brief Gets the tile renderer drawing for an SDL renderer.
+             *
+             * \param SDL_Renderer *<u>renderer</u>: The renderer being drawn to
+             * \return TileRenderer* Its tile renderer, or NULLPTR if it has none
+             *
+             */
+            static TileRenderer *Get(SDL_Renderer *renderer);
+
+            /** \brief Tells the renderer where a texture's pixels are, so sprites using it can
+             *        be drawn on the CPU.
+             *
+             * \param SDL_Texture *<u>texture</u>: The texture
+             * \param SDL_Surface *<u>source</u>: An ARGB8888 copy of its pixels; must live &
+             *        stay in step with the texture until remove_source()
+             *
+             */
+            void add_source(SDL_Texture *texture, const SDL_Surface *source);
+
+            /** \brief Forgets a texture's pixels, flushing first if anything is pending.
+             *
+             * \param SDL_Texture *<u>texture</u>: The texture
+             *
+             */
+            void remove_source(SDL_Texture *texture);
+
+            /** \brief Queues a sprite.
+             *
+             * \param Sprite &<u>sprite</u>: The sprite, as SpriteBatch would submit it
+             * \return bool FALSE if the sprite's texture has no source; nothing is queued
+             *
+             */
+            bool draw_sprite(const Sprite &sprite);
+
+            /** \brief Queues a filled rectangle.
+             *
+             * \param SDL_Rect &<u>rect</u>: The rectangle
+             * \param SDL_Color <u>color</u>: Its colour
+             * \param SDL_BlendMode <u><i>blend</i></u>: SDL_BLENDMODE_BLEND (default) or
+             *        SDL_BLENDMODE_NONE
+             *
+             */
+            void fill_rect(const SDL_Rect &rect, SDL_Color color,
+                           SDL_BlendMode blend = SDL_BLENDMODE_BLEND);
+
+            /** \brief Queues a copy of a block of ARGB8888 pixels, blended over what's there.
+             *
+             * \param Uint32 *<u>pixels</u>: The block's top left pixel
+             * \param int <u>stride</u>: Pixels from one row of the block to the next
+             * \param SDL_Rect &<u>rect</u>: Where the block goes; also its size
+             *
+             */
+            void draw_pixels(const Uint32 *pixels, int stride, const SDL_Rect &rect);
+
+            /** \brief Rasterizes every queued command into the surface.
+             */
+            void flush();
+
+            /** \brief Returns how many commands are queued.
+             *
+             * \return size_t Number of commands
+             *
+             */
+            size_t size();
+        };
+    }
+}
+
+#endif // GRAPHICS_TILES_HPP
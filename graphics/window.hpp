@@ -29,8 +29,13 @@
 #define GRAPHICS_WINDOW_HPP
 
 #include "base.hpp"
+#include "graphics/batch.hpp"
 #include "graphics/draw.hpp"
+#include "graphics/lines.hpp"
+#include "graphics/texcache.hpp"
+#include "graphics/tiles.hpp"
 #include "object.hpp"
+#include "thread.hpp"
 #include "time.hpp"
 
 #undef CreateWindow
@@ -44,6 +49,13 @@ namespace GenEx {
 
 // --- WINDOW-RELATED EVENT HANDLERS --------------------------------------------------------------
 
+        /** \brief What draws a window's frames
+         */
+        enum RenderBackend {
+            BACKEND_SDL, // an SDL_Renderer; hardware accelerated where the platform allows
+            BACKEND_TILES // GenEx's TileRenderer on the CPU, spread over the job pool
+        };
+
         struct WindowData {
             std::string title;
             int x;
@@ -53,23 +65,61 @@ namespace GenEx {
             Uint32 winflags;
             Uint32 renflags;
             double framerate;
+            double tickrate; // simulation steps per second; 0 for DEFAULT_TICKRATE
+
+            bool headless; // render into an offscreen surface instead of a window
+            std::string frame_dump; // printf-style BMP path for headless frames, e.g.
+                                    // "frame%05llu.bmp"; empty to not dump
+            Uint64 max_frames; // stop the window after this many frames; 0 to never stop
+            RenderBackend backend; // BACKEND_SDL unless set
         };
 
         const double DEFAULT_FRAMERATE = 144.0;
 
+        /** \brief The default amount of fixed simulation steps a window runs per second
+         */
+        const double DEFAULT_TICKRATE = 60.0;
+
+        /** \brief The most simulated time a window will catch up on in a single frame; keeps a
+         *        slow frame from snowballing into ever more simulation steps
+         */
+        const double MAX_FRAME_TIME = 0.25;
+
+        /** \brief Headless windows have no SDL window ID, so GenEx numbers them from here up;
+         *        SDL numbers its own windows from 1
+         */
+        const Uint32 HEADLESS_WINDOW_ID_BASE = 0x80000000;
+
 // --- THE WINDOW CLASS ---------------------------------------------------------------------------
 
         /** \brief The base Window class; a collection of objects contained in a GUI window
          */
         class Window : public Layer {
         private:
-            SDL_Window *window;
+            SDL_Window *window = nullptr;
             SDL_Renderer *renderer = nullptr;
             SDL_GLContext gl_context = nullptr;
+            SDL_Surface *surface = nullptr; // CPU target; headless & BACKEND_TILES windows only
+            Uint32 headless_id = 0; // window ID handed out by GenEx; headless windows only
+            std::unique_ptr<SpriteBatch> batch; // collects RenderImg() draws during render()
+            std::unique_ptr<TextureCache> textures; // RenderImg()'s textures for surfaces
+            std::unique_ptr<LineRasterizer> lines; // draws RenderLine() & RenderLines()
+            std::unique_ptr<TileRenderer> tiles; // draws into <surface> for BACKEND_TILES
 
             WindowData initdata;
 
-            double t_elapsed, t_prev;
+            double tickrate;
+            Uint64 frame_count = 0;
+            bool batching = false; // render() queues RenderImg() draws in <batch>
+
+            /** \brief Creates the SDL window & renderer, or the surface & software renderer
+             *        for headless & BACKEND_TILES windows.
+             *
+             * \param WindowData &<u>dt</u>: Position, size & flags to create with
+             * \param std::string <u>title</u>: The window title
+             *
+             */
+            void open(const WindowData &dt, std::string title);
 
         public:
             /** \brief Constructs a new window with the given window data & event handlers.
@@ -188,6 +238,24 @@ namespace GenEx {
              */
             void set_fullscreen(Uint32 fullscreen);
 
+            /** \brief Sets how many fixed simulation steps this window runs per second.
+             *
+             * \param double <u>tickrate</u>: Steps per second; 0 or less for
+             *        <i>DEFAULT_TICKRATE</i>
+             *
+             */
+            void set_tickrate(double tickrate);
+
+            /** \brief Sets whether render() batches RenderImg() draws by texture. Off by
+             *        default. While on, a texture passed to RenderImg() must live until the
+             *        frame ends, & handlers drawing through SDL directly must call
+             *        FlushRenderer() first.
+             *
+             * \param bool <u>batching</u>: TRUE to batch sprite draws
+             *
+             */
+            void set_batching(bool batching);
+
 // ------ ACCELERATION-RELATED FUNCTIONS ----------------------------------------------------------
 
             /** \brief Set this window to be the current OpenGL context
@@ -196,6 +264,12 @@ namespace GenEx {
 
 // ------ WINDOW FLAGS/DATA GETTERS ---------------------------------------------------------------
 
+            /** \brief Gets the ID events for this window carry.
+             *
+             * \return Uint32 The SDL window ID, or for a headless window an ID of
+             *         <i>HEADLESS_WINDOW_ID_BASE</i> or more that only replayed events use
+             *
+             */
             Uint32 get_window_id();
 
             /** \brief Gets which display the window is a part of.
@@ -240,6 +314,56 @@ namespace GenEx {
              */
             float get_opacity();
 
+            /** \brief Gets how many fixed simulation steps this window runs per second.
+             *
+             * \return double Steps per second
+             *
+             */
+            double get_tickrate();
+
+            /** \brief Returns whether render() batches RenderImg() draws.
+             *
+             * \return bool TRUE if sprite draws are batched
+             *
+             */
+            bool is_batching();
+
+            /** \brief Returns whether or not this window renders offscreen.
+             *
+             * \return bool TRUE if the window is headless
+             *
+             */
+            bool is_headless();
+
+            /** \brief Gets the surface a headless or BACKEND_TILES window renders into.
+             *
+             * \return SDL_Surface* The surface, or NULLPTR for other windows
+             *
+             */
+            SDL_Surface *get_surface();
+
+            /** \brief Gets the cache of textures RenderImg() makes from surfaces for this
+             *        window; cleared whenever the render targets are reset.
+             *
+             * \return TextureCache* The cache, or NULLPTR if the window isn't open
+             *
+             */
+            TextureCache *get_texture_cache();
+
+            /** \brief Gets how many frames this window has rendered.
+             *
+             * \return Uint64 Number of rendered frames
+             *
+             */
+            Uint64 get_frame_count();
+
+            /** \brief Gets how many frames this window renders before it stops.
+             *
+             * \return Uint64 The frame limit; 0 if the window never stops on its own
+             *
+             */
+            Uint64 get_max_frames();
+
 // ------ WINDOW EVENT HANDLERS -------------------------------------------------------------------
 
             /** \brief Destroys this window
@@ -248,6 +372,13 @@ namespace GenEx {
 
             virtual void render(SDL_Renderer *target, int offset_x, int offset_y, int offset_z);
 
+            /** \brief Runs one simulation step.
+             *
+             * \param double <u>elapsed</u>: The length of the step in seconds; RunWindow()
+             *        always passes <i>1.0 / get_tickrate()</i>
+             * \return bool TRUE to continue running the application
+             *
+             */
             virtual bool update(double elapsed);
 
             virtual bool windowevent(Uint8 event, Sint32 data1, Sint32 data2);
@@ -268,14 +399,26 @@ namespace GenEx {
         struct WindowThreadData {
             const std::string name;
             Window *window;
-            SDL_cond *c;
-            SDL_mutex *m;
-            std::vector<SDL_Event> event_buffer;
+            Thread::EventRing events; // events handed from the main thread to the window thread
+            std::vector<SDL_Event> overflow; // events that didn't fit in the ring yet; main
+                                             // thread only
             const double framerate;
-            bool complete;
+            std::atomic<bool> complete;
+
+            /** \brief Constructs the thread data for a window.
+             *
+             * \param std::string <u>name</u>: The name of the window thread
+             * \param Window *<u>window</u>: The window run by the thread
+             * \param double <u>framerate</u>: How many frames per second to hand events over at
+             *
+             */
+            WindowThreadData(std::string name, Window *window, double framerate);
         };
 
-        /** \brief Thread function to run a GenEx Window.
+        /** \brief Thread function to run a GenEx Window. Simulates in fixed steps of
+         *        <i>1.0 / Window::get_tickrate()</i> seconds and renders once per frame,
+         *        interpolating between the last two steps. Headless windows log their frame
+         *        throughput when they stop.
          *
          * \param void *<u>data</u>: Pointer to a WindowThreadData struct
          * \return int The return code of the window
@@ -305,6 +448,10 @@ namespace GenEx {
          * \param Uint32 <u><i>renflags</i></u>: Flags for setting up the window renderer
          * \param Events::EventHandlers <u><i>evt_handlers</i></u>: Event handlers for the
          *        window to use
+         * \param double <u><i>framerate</i></u>: Frames per second; defaults to
+         *        <i>DEFAULT_FRAMERATE</i>
+         * \param double <u><i>tickrate</i></u>: Simulation steps per second; defaults to
+         *        <i>DEFAULT_TICKRATE</i>
          * \return WindowThreadData Pointers to the created Window and a return code for when the
          *         window closes
          *
@@ -314,7 +461,167 @@ namespace GenEx {
                                        Uint32 renflags = DEFAULT_RENFLAGS,
                                        Events::EventHandlers evt_handlers =
                                            Events::GenerateEventHandlerStruct(),
-                                       double framerate = DEFAULT_FRAMERATE);
+                                       double framerate = DEFAULT_FRAMERATE,
+                                       double tickrate = DEFAULT_TICKRATE);
+
+// --- WINDOW EVENT ROUTING -----------------------------------------------------------------------
+
+        /** \brief Sorts polled SDL_Events into one bucket per window plus a lane of global
+         *        events (joysticks, touch, clipboard, etc.) that every window receives.
+         *
+         * Each event is classified once when routed; draining a window merges its bucket with
+         * the global events it hasn't seen yet, in the order they were polled.
+         */
+        class EventRouter {
+        private:
+            struct RoutedEvent {
+                Uint64 seq;
+                SDL_Event event;
+            };
+
+            struct Bucket {
+                std::vector<RoutedEvent> events;
+                Uint64 global_cursor; // seq of the first global event not yet drained
+                bool active;
+            };
+
+            std::vector<int> slot_table; // SDL window ID -> bucket slot; -1 if not routed
+            std::vector<int> headless_slot_table; // the same from HEADLESS_WINDOW_ID_BASE up
+            std::vector<Bucket> buckets;
+            std::vector<int> free_slots;
+
+            std::vector<RoutedEvent> global_lane;
+            Uint64 next_seq = 0;
+
+            bool coalescing = false;
+
+            int get_slot(Uint32 window_id) const;
+            void set_slot(Uint32 window_id, int slot);
+
+        public:
+            /** \brief Folds an event into the one before it if both are motion events for the
+             *        same device: mouse motion sums xrel/yrel, finger motion sums dx/dy and axis
+             *        motion keeps the latest value. Positions & timestamps come from <u>next</u>.
+             *
+             * \param SDL_Event &<u>into</u>: The earlier event; updated in place on success
+             * \param SDL_Event &<u>next</u>: The event that directly follows <u>into</u>
+             * \return bool TRUE if <u>next</u> was folded into <u>into</u>
+             *
+             */
+            static bool CoalesceEvents(SDL_Event &into, const SDL_Event &next);
+
+            /** \brief Gets the ID of the window an event is meant for.
+             *
+             * \param SDL_Event &<u>event</u>: An SDL event
+             * \return Uint32 The SDL window ID, or 0 if the event isn't tied to a window
+             *
+             */
+            static Uint32 GetEventWindowID(const SDL_Event &event);
+
+            /** \brief Changes which window an event is meant for. Events that aren't tied to a
+             *        window are left alone.
+             *
+             * \param SDL_Event &<u>event</u>: An SDL event
+             * \param Uint32 <u>window_id</u>: The new SDL window ID
+             *
+             */
+            static void SetEventWindowID(SDL_Event &event, Uint32 window_id);
+
+            /** \brief Starts routing events to a window. Headless windows get the global
+             *        events & whatever is addressed to their GenEx-assigned ID.
+             *
+             * \param Uint32 <u>window_id</u>: The ID from Window::get_window_id()
+             *
+             */
+            void add_window(Uint32 window_id);
+
+            /** \brief Stops routing events to a window and drops any it hasn't drained.
+             *
+             * \param Uint32 <u>window_id</u>: The SDL window ID
+             *
+             */
+            void remove_window(Uint32 window_id);
+
+            /** \brief Classifies an event into its window's bucket or the global lane. Events
+             *        for windows that aren't being routed are dropped.
+             *
+             * \param SDL_Event &<u>event</u>: The event to route
+             *
+             */
+            void route(const SDL_Event &event);
+
+            /** \brief Sets whether drain() merges runs of motion events into one. Any other
+             *        event ends a run, so buttons & keys keep their exact order relative to
+             *        the motion around them. Off by default, since handlers then only see the
+             *        last motion of each run.
+             *
+             * \param bool <u>coalescing</u>: TRUE to merge motion events
+             *
+             */
+            void set_coalescing(bool coalescing);
+
+            /** \brief Returns whether drain() merges runs of motion events.
+             *
+             * \return bool TRUE if motion events are merged
+             *
+             */
+            bool is_coalescing() const;
+
+            /** \brief Hands every pending event for a window to a callback, in polled order,
+             *        and empties its bucket.
+             *
+             * \param Uint32 <u>window_id</u>: The SDL window ID
+             * \param F <u>sink</u>: Callable taking a <i>const SDL_Event&</i>
+             *
+             */
+            template <typename F>
+            void drain(Uint32 window_id, F sink) {
+                int slot = get_slot(window_id);
+                if (slot < 0)
+                    return;
+                Bucket &bucket = buckets[slot];
+
+                // skip global events this window has already seen
+                auto git = global_lane.begin();
+                while (git != global_lane.end() && git->seq < bucket.global_cursor)
+                    git++;
+
+                SDL_Event pending;
+                bool has_pending = false;
+
+                auto wit = bucket.events.begin();
+                while (wit != bucket.events.end() || git != global_lane.end()) {
+                    const SDL_Event *event;
+                    if (git == global_lane.end() ||
+                            (wit != bucket.events.end() && wit->seq < git->seq)) {
+                        event = &wit->event;
+                        wit++;
+                    }
+                    else {
+                        event = &git->event;
+                        git++;
+                    }
+
+                    if (!coalescing)
+                        sink(*event);
+                    else if (!has_pending || !CoalesceEvents(pending, *event)) {
+                        if (has_pending)
+                            sink(pending);
+                        pending = *event;
+                        has_pending = true;
+                    }
+                }
+                if (has_pending)
+                    sink(pending);
+
+                bucket.events.clear();
+                bucket.global_cursor = next_seq;
+            }
+
+            /** \brief Discards global events every routed window has already drained.
+             */
+            void trim();
+        };
     }
 }
 
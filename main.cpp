@@ -29,32 +29,158 @@
 
 using namespace GenEx;
 
+/** \brief Settings taken from the command line.
+ */
+struct Options {
+    bool headless = false;     // --headless: render offscreen with no display
+    Uint64 max_frames = 0;     // --frames N: stop headless windows after N frames
+    std::string frame_dump;    // --dump PATTERN: save headless frames, e.g. "frame%05llu.bmp"
+    std::string record_path;   // --record FILE: write every polled event to an event log
+    std::string replay_path;   // --replay FILE: play an event log instead of live input
+    bool replay_fast = false;  // --replay-fast: skip the idle time between logged events
+    bool bench = false;        // --bench: print engine benchmarks & exit
+    bool tiles = false;        // --tiles: draw on the CPU with the tile renderer
+    bool coalesce = false;     // --coalesce: merge runs of motion events before routing them
+};
+
+/** \brief Reads the command line.
+ *
+ * \param int <u>argc</u>: Number of arguments
+ * \param char *<u>argv</u>[]: The arguments
+ * \return Options The settings that were given
+ *
+ */
+Options parse_options(int argc, char *argv[]) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--headless")
+            options.headless = true;
+        else if (arg == "--frames" && i + 1 < argc)
+            options.max_frames = std::stoull(argv[++i]);
+        else if (arg == "--dump" && i + 1 < argc)
+            options.frame_dump = argv[++i];
+        else if (arg == "--record" && i + 1 < argc)
+            options.record_path = argv[++i];
+        else if (arg == "--replay" && i + 1 < argc)
+            options.replay_path = argv[++i];
+        else if (arg == "--replay-fast")
+            options.replay_fast = true;
+        else if (arg == "--bench")
+            options.bench = true;
+        else if (arg == "--tiles")
+            options.tiles = true;
+        else if (arg == "--coalesce")
+            options.coalesce = true;
+    }
+    return options;
+}
+
 /** \brief Handles event polling.
  *
  * \param Layer &<u>winlayer</u>: The top level layer
  * \param std::unordered_map &<u>windowthreads</u>: A map containing the window thread data
- * \param std::vector &<u>events</u>: A vector in which to place the events
+ * \param Graphics::EventRouter &<u>router</u>: The router to sort polled events into
+ * \param Time::FrameScheduler &<u>scheduler</u>: The scheduler to add new windows to
+ * \param Options &<u>options</u>: Command line settings
+ * \param Replay::Recorder *<u>recorder</u>: Where to log polled events; NULLPTR to not record
+ * \param Replay::Player *<u>player</u>: Event log to take events from instead of SDL; NULLPTR
+ *        for live input
+ * \return bool FALSE if the application was asked to quit
  *
  */
-void poll_events(Layer &winlayer,
+bool poll_events(Layer &winlayer,
                  std::unordered_map<Uint64, Graphics::WindowThreadData*> &windowthreads,
-                 std::vector<SDL_Event> &events) {
+                 Graphics::EventRouter &router, Time::FrameScheduler &scheduler,
+                 const Options &options, Replay::Recorder *recorder, Replay::Player *player) {
+    bool running = true;
+
     SDL_Event event;
-    while (SDL_PollEvent(&event)) {
+    double now = Time::GetTime();
+    if (player != nullptr) {
+        // live input is dropped so it can't disturb the replayed session
+        while (SDL_PollEvent(&event))
+            if (event.type == SDL_QUIT)
+                running = false;
+        player->begin_poll(now);
+    }
+
+    while (player != nullptr ? player->poll(event, now) : SDL_PollEvent(&event)) {
+        if (recorder != nullptr)
+            recorder->record(event);
+
         if (event.type == GENEX_CREATEWINDOWEVENT) {
             Graphics::WindowData  *windt        = (Graphics::WindowData*)  event.user.data1;
-            Events::EventHandlers *evt_handlers = (Events::EventHandlers*) event.user.data2;
-            Graphics::WindowThreadData *wd = Graphics::CreateWindow(*windt, *evt_handlers);
+            const Events::HandlerTable *handler_table =
+                (const Events::HandlerTable*) event.user.data2; // interned; never freed
+
+            if (player != nullptr && options.headless) {
+                windt->headless = true;
+                windt->framerate = 0.0;
+                windt->frame_dump = options.frame_dump;
+                windt->max_frames = options.max_frames;
+            }
+            if (player != nullptr && options.tiles)
+                windt->backend = Graphics::BACKEND_TILES;
+            Graphics::WindowThreadData *wd = Graphics::CreateWindow(*windt,
+                                                                    handler_table->handlers);
 
             delete windt;
-            delete evt_handlers;
 
             windowthreads[wd->window->get_id()] = wd;
             winlayer.add_object(std::shared_ptr<Object>(wd->window),
                                 std::string("win") + std::to_string(wd->window->get_id()));
+            router.add_window(wd->window->get_window_id());
+            scheduler.add(wd->window->get_id(), wd->framerate, Time::GetTime());
+
+            if (recorder != nullptr)
+                recorder->add_window(wd->window->get_window_id());
+            if (player != nullptr)
+                player->add_window(wd->window->get_window_id());
             continue;
         }
-        events.emplace_back(event);
+        else if (event.type == SDL_QUIT) {
+            running = false;
+            continue;
+        }
+        router.route(event);
+    }
+
+    return running;
+}
+
+/** \brief Sleeps until a deadline passes or an event arrives.
+ *
+ * \param double <u>deadline</u>: When to wake up at the latest; see <i>Time::GetTime()</i>
+ *
+ */
+void wait_for_events(double deadline) {
+    // SDL only re-checks its queue every EVENT_WAIT_STEP ms inside SDL_WaitEventTimeout, so
+    // block there for the coarse part of the wait and nap in 1ms steps for the rest
+    static const Uint32 EVENT_WAIT_STEP = 10;
+
+    // nothing is scheduled; only input can give us something to do
+    if (std::isinf(deadline)) {
+        SDL_WaitEvent(nullptr);
+        return;
+    }
+
+    for (;;) {
+        double remaining = deadline - Time::GetTime();
+        if (remaining <= 0.0)
+            return;
+
+        double ms = remaining * 1000.0;
+        if (ms > 2 * EVENT_WAIT_STEP) {
+            if (SDL_WaitEventTimeout(nullptr, (int)(ms) - EVENT_WAIT_STEP))
+                return;
+        }
+        else {
+            SDL_PumpEvents();
+            if (SDL_HasEvents(SDL_FIRSTEVENT, SDL_LASTEVENT))
+                return;
+            SDL_Delay(ms >= 1.0 ? 1 : 0);
+        }
     }
 }
 
@@ -70,12 +196,10 @@ void addwin(Graphics::WindowData &windt, Events::EventHandlers &evt_handlers) {
 
     Graphics::WindowData *wd = new Graphics::WindowData();
     *wd = windt;
-    Events::EventHandlers *evh = new Events::EventHandlers();
-    *evh = evt_handlers;
 
     evt.type = GENEX_CREATEWINDOWEVENT;
     evt.user.data1 = (void*)(wd);
-    evt.user.data2 = (void*)(evh);
+    evt.user.data2 = (void*)(Events::InternEventHandlers(evt_handlers));
 
     SDL_PushEvent(&evt);
 }
@@ -89,6 +213,8 @@ void addwin(Graphics::WindowData &windt, Events::EventHandlers &evt_handlers) {
  * \param int <u>h</u>: The window's height
  * \param Uint32 <u><i>winflags</i></u>: Flags for setting up the window
  * \param Uint32 <u><i>renflags</i></u>: Flags for setting up the window renderer
+ * \param double <u><i>framerate</i></u>: Frames per second
+ * \param double <u><i>tickrate</i></u>: Simulation steps per second
  * \param Events::EventHandlers <u><i>evt_handlers</i></u>: Event handlers for the window to use
  *
  */
@@ -96,101 +222,122 @@ void addwin(std::string title, int x, int y, int w, int h,
             Uint32 winflags = DEFAULT_WINFLAGS,
             Uint32 renflags = DEFAULT_RENFLAGS,
             double framerate = Graphics::DEFAULT_FRAMERATE,
+            double tickrate = Graphics::DEFAULT_TICKRATE,
             Events::EventHandlers evt_handlers = Events::GenerateEventHandlerStruct()) {
-    Graphics::WindowData windt = {title, x, y, w, h, winflags, renflags, framerate};
+    Graphics::WindowData windt = {title, x, y, w, h, winflags, renflags, framerate, tickrate};
     addwin(windt, evt_handlers);
 }
 
 int main(int argc, char *argv[]) {
+    Options options = parse_options(argc, argv);
+
     // initialize SGE/GenEx
-    if (!Init()) {
+    if (!Init(options.headless)) {
         return -1;
     }
     std::cout << Debug::GetVersionString() << '\n';
 
+    if (options.bench) {
+        std::cout << Debug::BenchmarkLayer();
+        std::cout << Debug::BenchmarkLines();
+        SDL_Quit();
+        return 0;
+    }
+
     // Things to keep track of top-level objects
     Layer winlayer; // PARENT WINDOW LAYER
     std::unordered_map<Uint64, Graphics::WindowThreadData*> windowthreads;
-    std::unordered_map<Uint64, double> windowtimes;
 
-    {
-        addwin("Test", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, 1280, 720);
+    std::unique_ptr<Replay::Recorder> recorder;
+    if (!options.record_path.empty())
+        recorder.reset(new Replay::Recorder(options.record_path));
+
+    std::unique_ptr<Replay::Player> player;
+    if (!options.replay_path.empty()) {
+        player.reset(new Replay::Player(options.replay_path, options.replay_fast));
+        if (!player->is_open()) {
+            SDL_Quit();
+            return -1;
+        }
+    }
+
+    // a replay opens its windows from the log
+    if (!player) {
+        // headless runs are for measuring throughput, so don't cap their framerate
+        Graphics::WindowData windt = {
+            "Test", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, 1280, 720,
+            DEFAULT_WINFLAGS, DEFAULT_RENFLAGS,
+            options.headless ? 0.0 : Graphics::DEFAULT_FRAMERATE, Graphics::DEFAULT_TICKRATE,
+            options.headless, options.frame_dump, options.max_frames,
+            options.tiles ? Graphics::BACKEND_TILES : Graphics::BACKEND_SDL
+        };
+        Events::EventHandlers evt_handlers = Events::GenerateEventHandlerStruct();
+        addwin(windt, evt_handlers);
     }
 
     bool quitflag = false;
-    std::vector<SDL_Event> events;
+    Graphics::EventRouter router;
+    router.set_coalescing(options.coalesce); // one tree walk per run of motion events
+    Time::FrameScheduler scheduler;
     while (!quitflag) {
-        poll_events(winlayer, windowthreads, events);
-
-        // loop through all top-level objects
-        for (auto pr = winlayer.begin(); pr != winlayer.end(); pr++) {
-            std::shared_ptr<GenEx::Object> obj = pr->second;
-            Uint64 obj_id = obj->get_id();
-
-            // handle windows
-            if (windowthreads.find(obj_id) != windowthreads.end()) {
-                if (windowthreads[obj_id]->complete) {
-                    SDL_DestroyCond(windowthreads[obj_id]->c);
-                    SDL_DestroyMutex(windowthreads[obj_id]->m);
-                    delete windowthreads[obj_id];
-
-                    windowthreads.erase(obj_id);
-                    obj->destroy();
-                    winlayer.remove_object(obj);
-                    break;
-                }
-                else {
-                    bool evt_flag = true;
-                    if (windowtimes.find(obj_id) != windowtimes.end() &&
-                            windowthreads[obj_id]->framerate > 0.0) {
-                        evt_flag = (Time::GetTime() - windowtimes[obj_id]) >
-                                       (1.0 / windowthreads[obj_id]->framerate);
-                    }
-
-                    if (evt_flag) {
-                        Graphics::Window *win = ((Graphics::Window*)(obj.get()));
-                        Uint32 win_id = win->get_window_id();
-
-                        SDL_LockMutex(windowthreads[obj_id]->m);
-
-                        for (auto &evt : events) {
-                            if (evt.type == SDL_QUIT) {
-                                quitflag = true;
-                                break;
-                            }
-
-                            if ((evt.type == SDL_WINDOWEVENT     &&
-                                    win_id == evt.window.windowID) ||
-                                (evt.type == SDL_MOUSEBUTTONDOWN &&
-                                    win_id == evt.button.windowID) ||
-                                (evt.type == SDL_MOUSEBUTTONUP   &&
-                                    win_id == evt.button.windowID) ||
-                                (evt.type == SDL_MOUSEMOTION     &&
-                                    win_id == evt.motion.windowID) ||
-                                (evt.type == SDL_MOUSEWHEEL      &&
-                                    win_id == evt.wheel.windowID)  ||
-                                 evt.type != SDL_WINDOWEVENT) {
-                                windowthreads[obj_id]->event_buffer.emplace_back(evt);
-                            }
-                        }
-
-                        SDL_CondSignal( windowthreads[obj_id]->c);
-                        SDL_UnlockMutex(windowthreads[obj_id]->m);
-
-                        windowtimes[obj_id] = Time::GetTime();
-                    }
-                }
+        // sleep until the next window is due for a frame or input arrives
+        double deadline = scheduler.next_deadline();
+        if (player)
+            deadline = std::min(deadline, player->next_deadline());
+        wait_for_events(deadline);
+        quitflag = !poll_events(winlayer, windowthreads, router, scheduler, options,
+                                recorder.get(), player.get());
+
+        // clean up windows that have closed
+        for (auto iter = windowthreads.begin(); iter != windowthreads.end(); ) {
+            if (iter->second->complete) {
+                Uint64 obj_id = iter->first;
+                std::shared_ptr<GenEx::Object> obj = winlayer.get_object(obj_id);
+
+                router.remove_window(iter->second->window->get_window_id());
+                scheduler.remove(obj_id);
+                delete iter->second;
+                iter = windowthreads.erase(iter);
+
+                obj->destroy();
+                winlayer.remove_object(obj);
             }
+            else
+                iter++;
+        }
+
+        // hand events over to every window whose frame is due
+        Uint64 obj_id;
+        double now = Time::GetTime();
+        while (scheduler.pop_due(now, obj_id)) {
+            Graphics::WindowThreadData *wtd = windowthreads[obj_id];
+
+            // hand over whatever didn't fit in the ring last time first
+            size_t flushed = 0;
+            while (flushed < wtd->overflow.size() &&
+                   wtd->events.push(wtd->overflow[flushed]))
+                flushed++;
+            wtd->overflow.erase(wtd->overflow.begin(), wtd->overflow.begin() + flushed);
+
+            router.drain(wtd->window->get_window_id(), [wtd](const SDL_Event &evt) {
+                if (!wtd->overflow.empty() || !wtd->events.push(evt))
+                    wtd->overflow.emplace_back(evt);
+            });
+
+            wtd->events.notify();
         }
 
-        events.clear();
+        router.trim();
 
-        if (winlayer.num_objects() < 1)
+        // a replay may not have opened its first window yet
+        if (winlayer.num_objects() < 1 && (!player || player->finished()))
             quitflag = true;
     }
 
     winlayer.destroy();
+    recorder.reset();
 
+    Thread::ShutdownJobPool();
     SDL_Quit();
     return 0;
 }
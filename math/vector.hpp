@@ -272,6 +272,21 @@ namespace GenEx {
              */
             T &operator[] (unsigned int index);
 
+            /** \brief Gives direct access to the items, without operator[]'s bounds check,
+             *        for loops over many vectors.
+             *
+             * \return T* Pointer to the first of the N items
+             *
+             */
+            T *data() { return items; }
+
+            /** \brief Gives read-only access to the items.
+             *
+             * \return const T* Pointer to the first of the N items
+             *
+             */
+            const T *data() const { return items; }
+
             /** \brief Vector negation. Flips the signs of the values in this vector.
              */
             Vector<N,T> operator- ();
@@ -30,29 +30,39 @@
 #include "util.hpp"
 #include "events.hpp"
 #include "object.hpp"
+#include "thread.hpp"
 
 // --- OBJECT CLASS -------------------------------------------------------------------------------
 
 Uint64 GenEx::Object::_num_instances = 0; // initialize _num_instances to 0 on start
+thread_local double GenEx::Object::interpolation = 1.0;
+thread_local int GenEx::Object::viewport_w = 0;
+thread_local int GenEx::Object::viewport_h = 0;
+thread_local int GenEx::Layer::render_depth = 0;
 
 // ------ CONSTRUCTORS ----------------------------------------------------------------------------
 
-GenEx::Object::Object(GenEx::Events::EventHandlers evt_handlers) : position({0, 0, 0}),
-                                                                   anchor_point({0.5, 0.5, 0.5}),
-                                                                   offset({0, 0, 0}),
-                                                                   rotation({0, 0, 0}),
-                                                                   scale({0, 0, 0}),
-                                                                   move_vector({0, 0, 0}),
-                                                                   angle_vector({0, 0, 0}),
-                                                                   event_handlers(evt_handlers) {
-    event_handlers.init(this);
+GenEx::Object::Object(const GenEx::Events::HandlerTable *table) : position({0, 0, 0}),
+                                                                 anchor_point({0.5, 0.5, 0.5}),
+                                                                 offset({0, 0, 0}),
+                                                                 rotation({0, 0, 0}),
+                                                                 scale({1, 1, 1}),
+                                                                 move_vector({0, 0, 0}),
+                                                                 angle_vector({0, 0, 0}),
+                                                                 prev_position({0, 0, 0}),
+                                                                 prev_rotation({0, 0, 0}),
+                                                                 handler_table(table) {
+    event_mask = handler_table->mask;
+    handler_table->handlers.init(this);
     instance_id = _num_instances++;
 }
 
-GenEx::Object::Object() : Object(GenEx::Events::GenerateEventHandlerStruct()) { }
+GenEx::Object::Object(GenEx::Events::EventHandlers evt_handlers) :
+    Object(GenEx::Events::InternEventHandlers(evt_handlers)) { }
 
-GenEx::Object::Object(const GenEx::Object &other) : Object(other.event_handlers) {
-    event_handlers = other.event_handlers;
+GenEx::Object::Object() : Object(GenEx::Events::GetDefaultHandlerTable()) { }
+
+GenEx::Object::Object(const GenEx::Object &other) : Object(other.handler_table) {
     position = other.position;
     anchor_point = other.anchor_point;
     offset = other.offset;
@@ -60,10 +70,19 @@ GenEx::Object::Object(const GenEx::Object &other) : Object(other.event_handlers)
     scale = other.scale;
     move_vector = other.move_vector;
     angle_vector = other.angle_vector;
-}
-
-GenEx::Object::Object(GenEx::Object &&other) : Object(other.event_handlers) {
-    event_handlers  = std::move(other.event_handlers);
+    prev_position = other.prev_position;
+    prev_rotation = other.prev_rotation;
+    integrated = other.integrated;
+    event_mask = other.event_mask;
+    subscribed = other.subscribed;
+    bounds_w = other.bounds_w;
+    bounds_h = other.bounds_h;
+    bounded = other.bounded;
+    opaque = other.opaque;
+    sort_key = other.sort_key;
+}
+
+GenEx::Object::Object(GenEx::Object &&other) : Object(other.handler_table) {
     position        = std::move(other.position);
     anchor_point    = std::move(other.anchor_point);
     offset          = std::move(other.offset);
@@ -71,13 +90,23 @@ GenEx::Object::Object(GenEx::Object &&other) : Object(other.event_handlers) {
     scale           = std::move(other.scale);
     move_vector     = std::move(other.move_vector);
     angle_vector    = std::move(other.angle_vector);
+    prev_position   = std::move(other.prev_position);
+    prev_rotation   = std::move(other.prev_rotation);
+    integrated      = other.integrated;
+    event_mask      = other.event_mask;
+    subscribed      = other.subscribed;
+    bounds_w        = other.bounds_w;
+    bounds_h        = other.bounds_h;
+    bounded         = other.bounded;
+    opaque          = other.opaque;
+    sort_key        = other.sort_key;
 }
 
 // ------ ASSIGNMENT OPERATORS --------------------------------------------------------------------
 
 GenEx::Object &GenEx::Object::operator= (const GenEx::Object &other) {
     if (&other != this) {
-        event_handlers = other.event_handlers;
+        handler_table = other.handler_table;
         position = other.position;
         anchor_point = other.anchor_point;
         offset = other.offset;
@@ -85,13 +114,25 @@ GenEx::Object &GenEx::Object::operator= (const GenEx::Object &other) {
         scale = other.scale;
         move_vector = other.move_vector;
         angle_vector = other.angle_vector;
+        prev_position = other.prev_position;
+        prev_rotation = other.prev_rotation;
+        integrated = other.integrated;
+        event_mask = other.event_mask;
+        subscribed = other.subscribed;
+        bounds_w = other.bounds_w;
+        bounds_h = other.bounds_h;
+        bounded = other.bounded;
+        opaque = other.opaque;
+        sort_key = other.sort_key;
+        transform_dirty = true;
+        invalidate_event_mask();
     }
     return *this;
 }
 
 GenEx::Object &GenEx::Object::operator= (GenEx::Object &&other) {
     if (&other != this) {
-        event_handlers = std::move(other.event_handlers);
+        handler_table = other.handler_table;
         position = std::move(other.position);
         anchor_point = std::move(other.anchor_point);
         offset = std::move(other.offset);
@@ -99,6 +140,18 @@ GenEx::Object &GenEx::Object::operator= (GenEx::Object &&other) {
         scale = std::move(other.scale);
         move_vector = std::move(other.move_vector);
         angle_vector = std::move(other.angle_vector);
+        prev_position = std::move(other.prev_position);
+        prev_rotation = std::move(other.prev_rotation);
+        integrated = other.integrated;
+        event_mask = other.event_mask;
+        subscribed = other.subscribed;
+        bounds_w = other.bounds_w;
+        bounds_h = other.bounds_h;
+        bounded = other.bounded;
+        opaque = other.opaque;
+        sort_key = other.sort_key;
+        transform_dirty = true;
+        invalidate_event_mask();
     }
     return *this;
 }
@@ -108,11 +161,15 @@ GenEx::Object &GenEx::Object::operator= (GenEx::Object &&other) {
 void GenEx::Object::destroy() {
     if (!dead) {
         dead = true;
-        event_handlers.destroy(this);
+        handler_table->handlers.destroy(this);
     }
 }
 
-GenEx::Object::~Object() { destroy(); }
+GenEx::Object::~Object() {
+    if (transform_store != nullptr)
+        transform_store->remove(this);
+    destroy();
+}
 
 bool GenEx::Object::is_dead() { return dead; }
 
@@ -122,168 +179,374 @@ Uint64 GenEx::Object::get_id() { return instance_id; }
 
 GenEx::Object *GenEx::Object::clone() { return new Object(*this); }
 
+GenEx::Events::EventMask GenEx::Object::get_event_mask() {
+    return mask_open ? Events::MASK_ALL : event_mask;
+}
+
+const GenEx::Events::EventHandlers &GenEx::Object::get_event_handlers() {
+    return handler_table->handlers;
+}
+
+void GenEx::Object::set_event_handlers(const GenEx::Events::EventHandlers &evt_handlers) {
+    set_handler_table(GenEx::Events::InternEventHandlers(evt_handlers));
+}
+
+void GenEx::Object::set_handler_table(const GenEx::Events::HandlerTable *table) {
+    if (table == handler_table)
+        return;
+
+    // bits from subscribe() can't be told apart from the old table's, so they stay set;
+    // a stale bit only costs a call to a default handler
+    event_mask |= table->mask;
+    handler_table = table;
+    invalidate_event_mask();
+}
+
+bool GenEx::Object::in_transform_store() { return transform_store != nullptr; }
+
+// ------ WORLD TRANSFORMS ------------------------------------------------------------------------
+
+std::atomic<Uint64> GenEx::Object::world_clock(0);
+
+void GenEx::Object::mark_transform_dirty() { transform_dirty = true; }
+
+void GenEx::Object::refresh_world_transform(const GenEx::WorldTransform &parent,
+                                            Uint64 parent_version) {
+    Math::Vector3 pos = get_render_position();
+    Math::Vector3 rot = get_render_rotation();
+    double inputs[8] = { pos[0] + offset[0], pos[1] + offset[1], pos[2] + offset[2], rot[2],
+                         scale[0], scale[1], bounded ? -anchor_point[0] * bounds_w : 0.0,
+                         bounded ? -anchor_point[1] * bounds_h : 0.0 };
+
+    // resting objects skip the trig & composition; moving ones are interpolated, so their
+    // inputs differ from one frame to the next
+    if (!transform_dirty && parent_version == this->parent_version &&
+            std::equal(inputs, inputs + 8, world_inputs))
+        return;
+    std::copy(inputs, inputs + 8, world_inputs);
+
+    double radians = Math::DegreesToRadians(inputs[3]);
+    double c = std::cos(radians), s = std::sin(radians);
+    double sx = inputs[4], sy = inputs[5];
+    double ax = inputs[6], ay = inputs[7];
+
+    // translate * rotate * scale * (-anchor)
+    GenEx::WorldTransform local;
+    local.xx = c * sx;
+    local.xy = -s * sy;
+    local.yx = s * sx;
+    local.yy = c * sy;
+    local.x0 = local.xx * ax + local.xy * ay + inputs[0];
+    local.y0 = local.yx * ax + local.yy * ay + inputs[1];
+    local.z0 = inputs[2];
+
+    GenEx::WorldTransform next = parent * local;
+    if (next != world || world_version == 0) {
+        world = next;
+        world_version = ++world_clock;
+    }
+    this->parent_version = parent_version;
+    transform_dirty = false;
+}
+
+const GenEx::WorldTransform &GenEx::Object::get_world_transform() { return world; }
+
+Uint64 GenEx::Object::get_world_version() { return world_version; }
+
+void GenEx::Object::commit_transform() {
+    if (transform_store != nullptr)
+        transform_store->gather(this);
+}
+
+void GenEx::Object::subscribe(GenEx::Events::EventMask mask) {
+    if (!subscribed) {
+        subscribed = true;
+        if (mask_open) {
+            mask_open = false;
+            invalidate_event_mask();
+        }
+    }
+    add_event_mask(mask);
+}
+
+void GenEx::Object::add_event_mask(GenEx::Events::EventMask mask) {
+    if ((event_mask | mask) != event_mask) {
+        event_mask |= mask;
+        invalidate_event_mask();
+    }
+}
+
+void GenEx::Object::invalidate_event_mask() {
+    for (GenEx::Layer *parent : parents)
+        parent->mark_subtree_dirty();
+}
+
+// ------ INTERPOLATION ---------------------------------------------------------------------------
+
+void GenEx::Object::SetInterpolation(double alpha) { interpolation = alpha; }
+
+double GenEx::Object::GetInterpolation() { return interpolation; }
+
+GenEx::Math::Vector3 GenEx::Object::get_render_position() {
+    if (!integrated)
+        return position; // nothing to interpolate from yet
+
+    Math::Vector3 delta = position - prev_position;
+    delta *= interpolation;
+    return prev_position + delta;
+}
+
+GenEx::Math::Vector3 GenEx::Object::get_render_rotation() {
+    if (!integrated)
+        return rotation;
+
+    Math::Vector3 delta = rotation - prev_rotation;
+    delta *= interpolation;
+    return prev_rotation + delta;
+}
+
+// ------ HIT-TESTING -----------------------------------------------------------------------------
+
+void GenEx::Object::set_bounds(double w, double h, bool opaque) {
+    bounds_w = w;
+    bounds_h = h;
+    bounded = true;
+    this->opaque = opaque;
+}
+
+void GenEx::Object::clear_bounds() {
+    bounded = false;
+    opaque = false;
+}
+
+bool GenEx::Object::has_bounds() { return bounded; }
+
+bool GenEx::Object::is_opaque() { return opaque; }
+
+GenEx::Bounds GenEx::Object::place_bounds(double x, double y) {
+    double w = std::abs(bounds_w * scale[0]);
+    double h = std::abs(bounds_h * scale[1]);
+    return GenEx::Bounds{ x - anchor_point[0] * w, y - anchor_point[1] * h, w, h };
+}
+
+GenEx::Bounds GenEx::Object::get_bounds() {
+    Math::Vector3 pos = get_render_position();
+    return place_bounds(pos[0] + offset[0], pos[1] + offset[1]);
+}
+
+void GenEx::Object::SetViewportSize(int w, int h) {
+    viewport_w = w;
+    viewport_h = h;
+}
+
+SDL_Point GenEx::Object::GetViewportSize() { return SDL_Point{ viewport_w, viewport_h }; }
+
 // ------ OBJECT EVENT HANDLERS -------------------------------------------------------------------
 
 void GenEx::Object::render(SDL_Renderer *target, int offset_x, int offset_y, int offset_z) {
-    event_handlers.render(this, target, offset_x, offset_y, offset_z);
+    handler_table->handlers.render(this, target, offset_x, offset_y, offset_z);
+}
+
+void GenEx::Object::integrate(double elapsed) {
+    // objects in a transform store were already moved by their layer's bulk pass
+    if (transform_store == nullptr) {
+        prev_position = position;
+        prev_rotation = rotation;
+
+        Math::Vector3 move = move_vector, turn = angle_vector;
+        move *= 60.0 * elapsed;
+        turn *= 60.0 * elapsed;
+        position += move;
+        rotation += turn;
+    }
+    integrated = true;
 }
 
 bool GenEx::Object::update(double elapsed) {
-    position += move_vector  * (60.0 / elapsed);
-    rotation += angle_vector * (60.0 / elapsed);
-    return event_handlers.update(this, elapsed);
+    integrate(elapsed);
+    return handler_table->handlers.update(this, elapsed);
 }
 
-bool GenEx::Object::targetreset() { return event_handlers.targetreset(this); }
+bool GenEx::Object::targetreset() { return handler_table->handlers.targetreset(this); }
 
 bool GenEx::Object::windowevent(Uint8 event, Sint32 data1, Sint32 data2) {
-    return event_handlers.windowevent(this, event, data1, data2);
+    return handler_table->handlers.windowevent(this, event, data1, data2);
 }
 
 bool GenEx::Object::keydown(SDL_Keycode key, SDL_Scancode scancode, Uint16 mod, Uint8 repeat) {
-    return event_handlers.keydown(this, key, scancode, mod, repeat);
+    return handler_table->handlers.keydown(this, key, scancode, mod, repeat);
 }
 
 bool GenEx::Object::keyup(SDL_Keycode key, SDL_Scancode scancode, Uint16 mod, Uint8 repeat) {
-    return event_handlers.keyup(this, key, scancode, mod, repeat);
+    return handler_table->handlers.keyup(this, key, scancode, mod, repeat);
 }
 
 bool GenEx::Object::textediting(char text[SDL_TEXTEDITINGEVENT_TEXT_SIZE],
                                  Sint32 start, Sint32 length) {
-    return event_handlers.textediting(this, text, start, length);
+    return handler_table->handlers.textediting(this, text, start, length);
 }
 
 bool GenEx::Object::textinput(char text[SDL_TEXTINPUTEVENT_TEXT_SIZE]) {
-    return event_handlers.textinput(this, text);
+    return handler_table->handlers.textinput(this, text);
 }
 
 bool GenEx::Object::mousedown(Sint32 x, Sint32 y, Uint8 button, Uint8 clicks, Uint32 which) {
-    return event_handlers.mousedown(this, x, y, button, clicks, which);
+    return handler_table->handlers.mousedown(this, x, y, button, clicks, which);
 }
 
 bool GenEx::Object::mouseup(Sint32 x, Sint32 y, Uint8 button, Uint8 clicks, Uint32 which) {
-    return event_handlers.mouseup(this, x, y, button, clicks, which);
+    return handler_table->handlers.mouseup(this, x, y, button, clicks, which);
 }
 
 bool GenEx::Object::mousemotion(Sint32 x, Sint32 y, Sint32 xrel, Sint32 yrel, bool buttons[5],
                                 Uint32 which) {
-    return event_handlers.mousemotion(this, x, y, xrel, yrel, buttons, which);
+    return handler_table->handlers.mousemotion(this, x, y, xrel, yrel, buttons, which);
 }
 
 bool GenEx::Object::mousewheel(bool flipped, Sint32 x, Sint32 y, Uint32 which) {
-    return event_handlers.mousewheel(this, flipped, x, y, which);
+    return handler_table->handlers.mousewheel(this, flipped, x, y, which);
 }
 
 bool GenEx::Object::clipboardupdate(char text[]) {
-    return event_handlers.clipboardupdate(this, text);
+    return handler_table->handlers.clipboardupdate(this, text);
 }
 
 bool GenEx::Object::filedrop(std::string filename) {
-    return event_handlers.filedrop(this, filename);
+    return handler_table->handlers.filedrop(this, filename);
 }
 
 bool GenEx::Object::textdrop(char text[]) {
-    return event_handlers.textdrop(this, text);
+    return handler_table->handlers.textdrop(this, text);
 }
 
 bool GenEx::Object::begindrop() {
-    return event_handlers.begindrop(this);
+    return handler_table->handlers.begindrop(this);
 }
 
 bool GenEx::Object::completedrop() {
-    return event_handlers.completedrop(this);
+    return handler_table->handlers.completedrop(this);
 }
 
 bool GenEx::Object::jaxis(SDL_JoystickID joystick_id, Uint8 axis, Sint16 value) {
-    return event_handlers.jaxis(this, joystick_id, axis, value);
+    return handler_table->handlers.jaxis(this, joystick_id, axis, value);
 }
 
 bool GenEx::Object::jball(SDL_JoystickID joystick_id, Uint8 ball, Sint16 x, Sint16 y) {
-    return event_handlers.jball(this, joystick_id, ball, x, y);
+    return handler_table->handlers.jball(this, joystick_id, ball, x, y);
 }
 
 bool GenEx::Object::jhat(SDL_JoystickID joystick_id, Uint8 hat, Uint8 value) {
-    return event_handlers.jhat(this, joystick_id, hat, value);
+    return handler_table->handlers.jhat(this, joystick_id, hat, value);
 }
 
 bool GenEx::Object::jbtndown(SDL_JoystickID joystick_id, Uint8 button) {
-    return event_handlers.jbtndown(this, joystick_id, button);
+    return handler_table->handlers.jbtndown(this, joystick_id, button);
 }
 
 bool GenEx::Object::jbtnup(SDL_JoystickID joystick_id, Uint8 button) {
-    return event_handlers.jbtnup(this, joystick_id, button);
+    return handler_table->handlers.jbtnup(this, joystick_id, button);
 }
 
 bool GenEx::Object::caxis(SDL_JoystickID controller_id, Uint8 axis, Sint16 value) {
-    return event_handlers.caxis(this, controller_id, axis, value);
+    return handler_table->handlers.caxis(this, controller_id, axis, value);
 }
 
 bool GenEx::Object::cbtndown(SDL_JoystickID controller_id, Uint8 button) {
-    return event_handlers.cbtndown(this, controller_id, button);
+    return handler_table->handlers.cbtndown(this, controller_id, button);
 }
 
 bool GenEx::Object::cbtnup(SDL_JoystickID controller_id, Uint8 button) {
-    return event_handlers.cbtnup(this, controller_id, button);
+    return handler_table->handlers.cbtnup(this, controller_id, button);
 }
 
 bool GenEx::Object::fingerdown(SDL_TouchID touch_id, SDL_FingerID finger_id, float x, float y,
                                float pressure) {
-    return event_handlers.fingerdown(this, touch_id, finger_id, x, y, pressure);
+    return handler_table->handlers.fingerdown(this, touch_id, finger_id, x, y, pressure);
 }
 
 bool GenEx::Object::fingerup(SDL_TouchID touch_id, SDL_FingerID finger_id, float x, float y,
                              float pressure) {
-    return event_handlers.fingerup(this, touch_id, finger_id, x, y, pressure);
+    return handler_table->handlers.fingerup(this, touch_id, finger_id, x, y, pressure);
 }
 
 bool GenEx::Object::fingermotion(SDL_TouchID touch_id, SDL_FingerID finger_id, float x, float y,
                                  float dx, float dy, float pressure) {
-    return event_handlers.fingermotion(this, touch_id, finger_id, x, y, dx, dy, pressure);
+    return handler_table->handlers.fingermotion(this, touch_id, finger_id, x, y, dx, dy, pressure);
 }
 
 bool GenEx::Object::gesturerecord(SDL_TouchID touch_id, SDL_GestureID gesture_id,
                                   Uint32 num_fingers, float x, float y) {
-    return event_handlers.gesturerecord(this, touch_id, gesture_id, num_fingers, x, y);
+    return handler_table->handlers.gesturerecord(this, touch_id, gesture_id, num_fingers, x, y);
 }
 
 bool GenEx::Object::gestureperform(SDL_TouchID touch_id, SDL_GestureID gesture_id,
                                    Uint32 num_fingers, float x, float y, float error) {
-    return event_handlers.gestureperform(this, touch_id, gesture_id, num_fingers, x, y, error);
+    return handler_table->handlers.gestureperform(this, touch_id, gesture_id, num_fingers, x, y,
+                                                  error);
 }
 
 bool GenEx::Object::multigesture(SDL_TouchID touch_id, Uint16 num_fingers, float x, float y,
                                  float d_theta, float d_dist) {
-    return event_handlers.multigesture(this, touch_id, num_fingers, x, y, d_theta, d_dist);
+    return handler_table->handlers.multigesture(this, touch_id, num_fingers, x, y, d_theta, d_dist);
 }
 
 bool GenEx::Object::userevent(Sint32 code, void *data1, void *data2) {
-    return event_handlers.userevent(this, code, data1, data2);
+    return handler_table->handlers.userevent(this, code, data1, data2);
 }
 
 // --- LAYER CLASS --------------------------------------------------------------------------------
 // ------ CONSTRUCTORS ----------------------------------------------------------------------------
 
-GenEx::Layer::Layer() : Object() { }
+GenEx::Layer::Layer() : Object() {
+    // children need moving even if this layer's handler doesn't; not a subscribe(), which
+    // would tell subclasses' overrides apart from the handlers
+    add_event_mask(Events::MASK_UPDATE);
+}
 
 GenEx::Layer::Layer(const GenEx::Layer &other) : Object(other) {
     objects = other.objects;
+    for (auto handle : other.pending_erase)
+        objects.erase(handle); // handles carry over with the copy
+    handles = other.handles;
     id_map = other.id_map;
+    name_map = other.name_map;
+    name_counters = other.name_counters;
+    render_list = other.render_list;
+    parallel = other.parallel;
+    parallel_grain = other.parallel_grain;
+    for (auto &iter : objects)
+        adopt(iter.second.get());
 }
 
 GenEx::Layer::Layer(GenEx::Layer &&other) : Object(other) {
     objects = std::move(other.objects);
+    for (auto handle : other.pending_erase)
+        objects.erase(handle);
+    other.pending_erase.clear();
+    handles = std::move(other.handles);
     id_map = std::move(other.id_map);
+    name_map = std::move(other.name_map);
+    name_counters = std::move(other.name_counters);
+    render_list = std::move(other.render_list);
+    transforms = std::move(other.transforms);
+    parallel = other.parallel;
+    parallel_grain = other.parallel_grain;
+    for (auto &iter : objects) {
+        other.disown(iter.second.get());
+        adopt(iter.second.get());
+    }
 }
 
-GenEx::Layer::Layer(Events::EventHandlers evt_handlers) : Object(evt_handlers) { }
+GenEx::Layer::Layer(Events::EventHandlers evt_handlers) : Object(evt_handlers) {
+    add_event_mask(Events::MASK_UPDATE);
+}
 
 GenEx::Layer::Layer(Events::EventHandlers evt_handlers,
              std::initializer_list< std::shared_ptr<GenEx::Object> > init_list) :
                  Layer(evt_handlers) {
     for (auto &objptr : init_list) {
         Uint64 objid = objptr->get_id();
-        objects[objid] = objptr;
-        id_map["object" + std::to_string(objid)] = objid;
+        insert_object(objptr, "object" + std::to_string(objid));
     }
 }
 
@@ -291,12 +554,12 @@ GenEx::Layer::Layer(std::initializer_list< std::shared_ptr<GenEx::Object> > init
     Layer(Events::GenerateEventHandlerStruct(), init_list) { }
 
 GenEx::Layer::Layer(Events::EventHandlers evt_handlers, std::initializer_list<GenEx::Object*>
-                        init_list) : Layer(event_handlers) {
+                        init_list) : Layer(evt_handlers) {
     for (auto &objptr : init_list) {
         if (objptr != nullptr) {
             Uint64 objid = objptr->get_id();
-            objects[objid] = std::shared_ptr<GenEx::Object>(objptr);
-            id_map["object" + std::to_string(objid)] = objid;
+            insert_object(std::shared_ptr<GenEx::Object>(objptr),
+                          "object" + std::to_string(objid));
         }
     }
 }
@@ -304,17 +567,57 @@ GenEx::Layer::Layer(Events::EventHandlers evt_handlers, std::initializer_list<Ge
 GenEx::Layer::Layer(std::initializer_list<GenEx::Object*> init_list) :
     Layer(Events::GenerateEventHandlerStruct(), init_list) { }
 
+GenEx::Layer::~Layer() {
+    for (auto &iter : objects)
+        disown(iter.second.get());
+}
+
 // ------ ASSIGNMENT OPERATORS --------------------------------------------------------------------
 
 GenEx::Layer &GenEx::Layer::operator= (const GenEx::Layer &other) {
+    transforms.reset(); // other's children belong to its store, if it has one
+    for (auto &iter : objects)
+        disown(iter.second.get());
     objects = other.objects;
+    for (auto handle : other.pending_erase)
+        objects.erase(handle); // handles carry over with the copy
+    pending_erase.clear();
+    handles = other.handles;
     id_map = other.id_map;
+    name_map = other.name_map;
+    name_counters = other.name_counters;
+    render_list = other.render_list;
+    parallel = other.parallel;
+    parallel_grain = other.parallel_grain;
+    for (auto &iter : objects)
+        adopt(iter.second.get());
+    mark_subtree_dirty();
+    hit_dirty = true;
     return *this;
 }
 
 GenEx::Layer &GenEx::Layer::operator= (GenEx::Layer &&other) {
+    transforms = std::move(other.transforms);
+    for (auto &iter : objects)
+        disown(iter.second.get());
     objects = std::move(other.objects);
+    for (auto handle : other.pending_erase)
+        objects.erase(handle);
+    pending_erase.clear();
+    other.pending_erase.clear();
+    handles = std::move(other.handles);
     id_map = std::move(other.id_map);
+    name_map = std::move(other.name_map);
+    name_counters = std::move(other.name_counters);
+    render_list = std::move(other.render_list);
+    parallel = other.parallel;
+    parallel_grain = other.parallel_grain;
+    for (auto &iter : objects) {
+        other.disown(iter.second.get());
+        adopt(iter.second.get());
+    }
+    mark_subtree_dirty();
+    hit_dirty = true;
     return *this;
 }
 
@@ -323,56 +626,393 @@ GenEx::Layer &GenEx::Layer::operator= (GenEx::Layer &&other) {
 void GenEx::Layer::destroy() {
     if (!is_dead()) {
         Object::destroy();
+
+        // children may outlive the layer, so they mustn't keep pointing back at it
+        for (auto &iter : objects)
+            disown(iter.second.get());
+        if (traversals > 0)
+            for (auto &iter : objects)
+                graveyard.push_back(std::move(iter.second));
         objects.clear();
+        pending_erase.clear();
+        handles.clear();
         id_map.clear();
+        name_map.clear();
+        name_counters.clear();
+        render_list.clear();
+        transforms.reset();
+
+        // the grid points at the children that were just dropped
+        hit_cells.clear();
+        hit_spans.clear();
+        hit_always.clear();
+        hit_dirty = true;
     }
 }
 
 GenEx::Object *GenEx::Layer::clone() {
     GenEx::Layer *new_layer = new GenEx::Layer();
-    for (auto iter = objects.begin(); iter != objects.end(); iter++) {
-        std::vector<std::string> vec;
-        GenEx::Util::FindByValue(vec, id_map, iter->second->get_id());
-        std::shared_ptr<Object> sp(iter->second);
-        new_layer->add_object(sp, vec[0]);
+    new_layer->objects.reserve(objects.size());
+    for (size_t i = 0; i < objects.size(); i++) {
+        if (!is_stored(i))
+            continue;
+        std::shared_ptr<Object> sp(objects[i].second);
+        new_layer->add_object(sp, name_map[objects[i].first]);
     }
     return new_layer;
 }
 
-size_t GenEx::Layer::num_objects() { return objects.size(); }
+size_t GenEx::Layer::num_objects() { return objects.size() - pending_erase.size(); }
+
+void GenEx::Layer::set_hit_cell_size(double size) {
+    if (size > 0) {
+        hit_cell_size = size;
+        hit_dirty = true;
+    }
+}
+
+void GenEx::Layer::invalidate_hit_grid() { hit_moved = true; }
+
+namespace {
+    Uint64 HitCellKey(long cx, long cy) {
+        return ((Uint64)(Uint32)cx << 32) | (Uint64)(Uint32)cy;
+    }
+}
+
+GenEx::Layer::HitSpan GenEx::Layer::get_hit_span(GenEx::Object *child) {
+    HitSpan span = { 0, 0, -1, -1, true };
+    if (!child->has_bounds())
+        return span;
+
+    // the child is drawn somewhere between its last two positions until the next update, so
+    // it's filed over both & the exact box is checked per event
+    GenEx::Bounds bounds = child->get_bounds();
+    double x1 = bounds.x + bounds.w, y1 = bounds.y + bounds.h;
+    if (child->integrated) {
+        GenEx::Bounds from = child->place_bounds(child->prev_position[0] + child->offset[0],
+                                                 child->prev_position[1] + child->offset[1]);
+        GenEx::Bounds to = child->place_bounds(child->position[0] + child->offset[0],
+                                               child->position[1] + child->offset[1]);
+        bounds.x = std::min(from.x, to.x);
+        bounds.y = std::min(from.y, to.y);
+        x1 = std::max(from.x + from.w, to.x + to.w);
+        y1 = std::max(from.y + from.h, to.y + to.h);
+    }
+    span.x0 = (long)std::floor(bounds.x / hit_cell_size);
+    span.y0 = (long)std::floor(bounds.y / hit_cell_size);
+    span.x1 = (long)std::floor(x1 / hit_cell_size);
+    span.y1 = (long)std::floor(y1 / hit_cell_size);
+    span.always = (span.x1 - span.x0 + 1) * (span.y1 - span.y0 + 1) > MAX_HIT_CELLS;
+    return span;
+}
+
+void GenEx::Layer::build_hit_grid() {
+    hit_cells.clear();
+    hit_spans.clear();
+    hit_always.clear();
+
+    // dead children are filed too, so the grid matches the storage; dispatch skips them
+    for (auto &iter : objects) {
+        GenEx::Object *child = iter.second.get();
+        HitSpan span = get_hit_span(child);
+        hit_spans[child] = span;
+
+        if (span.always) {
+            hit_always.push_back(child);
+            continue;
+        }
+        for (long cx = span.x0; cx <= span.x1; cx++)
+            for (long cy = span.y0; cy <= span.y1; cy++)
+                hit_cells[HitCellKey(cx, cy)].push_back(child);
+    }
+
+    hit_dirty = false;
+    hit_moved = false;
+}
+
+void GenEx::Layer::refresh_hit_grid() {
+    if (hit_dirty) {
+        build_hit_grid();
+        return;
+    }
+    if (!hit_moved)
+        return;
+
+    for (auto &iter : objects) {
+        GenEx::Object *child = iter.second.get();
+        auto filed = hit_spans.find(child);
+        if (filed == hit_spans.end()) {
+            build_hit_grid();
+            return;
+        }
+
+        HitSpan span = get_hit_span(child);
+        HitSpan &old = filed->second;
+        if (span.always || old.always) {
+            // hit_always keeps the children's order, so joining or leaving it means a rebuild
+            if (span.always != old.always) {
+                build_hit_grid();
+                return;
+            }
+            continue;
+        }
+        if (span.x0 == old.x0 && span.y0 == old.y0 && span.x1 == old.x1 && span.y1 == old.y1)
+            continue;
+
+        for (long cx = old.x0; cx <= old.x1; cx++) {
+            for (long cy = old.y0; cy <= old.y1; cy++) {
+                auto cell = hit_cells.find(HitCellKey(cx, cy));
+                if (cell == hit_cells.end())
+                    continue;
+
+                auto &list = cell->second;
+                auto pos = std::find(list.begin(), list.end(), child);
+                if (pos != list.end()) {
+                    *pos = list.back();
+                    list.pop_back();
+                }
+                if (list.empty())
+                    hit_cells.erase(cell);
+            }
+        }
+        for (long cx = span.x0; cx <= span.x1; cx++)
+            for (long cy = span.y0; cy <= span.y1; cy++)
+                hit_cells[HitCellKey(cx, cy)].push_back(child);
+        old = span;
+    }
+
+    hit_moved = false;
+}
+
+bool GenEx::Layer::dispatch_pointer(double x, double y, GenEx::Events::EventMask kind,
+                                    const std::function<bool(GenEx::Object*)> &fn) {
+    refresh_hit_grid();
+    TraversalGuard guard(this);
+
+    // children are positioned relative to where their layer was drawn
+    const GenEx::WorldTransform &placed = get_world_transform();
+    double lx = x - std::lround(placed.x0), ly = y - std::lround(placed.y0);
+
+    // borrow the scratch list; a handler sending another event through here gets a fresh one
+    std::vector<GenEx::Object*> hits;
+    hits.swap(hit_scratch);
+    hits.clear();
+
+    auto cell = hit_cells.find(HitCellKey((long)std::floor(lx / hit_cell_size),
+                                          (long)std::floor(ly / hit_cell_size)));
+    if (cell != hit_cells.end())
+        for (auto &objptr : cell->second)
+            if ((objptr->get_event_mask() & kind) && objptr->get_bounds().contains(lx, ly))
+                hits.push_back(objptr);
+    for (auto &objptr : hit_always)
+        if (objptr->has_bounds() && (objptr->get_event_mask() & kind) &&
+                objptr->get_bounds().contains(lx, ly))
+            hits.push_back(objptr);
+
+    // front to back: the reverse of the draw order
+    std::sort(hits.begin(), hits.end(),
+        [](GenEx::Object *a, GenEx::Object *b) {
+            if (a->position[2] != b->position[2])
+                return a->position[2] > b->position[2];
+            if (a->sort_key != b->sort_key)
+                return a->sort_key > b->sort_key;
+            return a->get_id() > b->get_id();
+        });
+
+    bool result = true;
+    for (GenEx::Object *objptr : hits) {
+        if (objptr->is_dead())
+            continue;
+        if (!fn(objptr)) {
+            result = false;
+            break;
+        }
+        if (objptr->is_opaque())
+            break;
+    }
+
+    if (result) {
+        for (GenEx::Object *objptr : hit_always) {
+            if (objptr->has_bounds() || objptr->is_dead() || !(objptr->get_event_mask() & kind))
+                continue;
+            if (!fn(objptr)) {
+                result = false;
+                break;
+            }
+        }
+    }
+
+    hit_scratch.swap(hits);
+    return result;
+}
+
+GenEx::Events::EventMask GenEx::Layer::get_event_mask() {
+    if (subtree_dirty.exchange(false)) {
+        // a change during the walk sets the flag again, so this is recomputed next time
+        Events::EventMask mask = Object::get_event_mask();
+        for (auto &iter : objects)
+            mask |= iter.second->get_event_mask();
+        subtree_mask = mask;
+    }
+    return subtree_mask;
+}
+
+void GenEx::Layer::mark_subtree_dirty() {
+    // a layer that's already dirty has dirty layers all the way up
+    if (!subtree_dirty.exchange(true))
+        invalidate_event_mask();
+}
+
+void GenEx::Layer::adopt(GenEx::Object *child) {
+    child->parents.push_back(this);
+
+    // subclasses that never subscribed may override any handler; Objects & Layers can't
+    child->mask_open = !child->subscribed && typeid(*child) != typeid(GenEx::Object) &&
+                       typeid(*child) != typeid(GenEx::Layer);
+}
+
+void GenEx::Layer::disown(GenEx::Object *child) {
+    auto &parents = child->parents;
+    auto iter = std::find(parents.begin(), parents.end(), this);
+    if (iter != parents.end()) {
+        *iter = parents.back();
+        parents.pop_back();
+    }
+}
+
+void GenEx::Layer::set_parallel(bool parallel, size_t grain) {
+    this->parallel = parallel;
+    parallel_grain = (grain > 0) ? grain : 1;
+}
+
+bool GenEx::Layer::is_parallel() { return parallel; }
+
+void GenEx::Layer::set_bulk_transforms(bool bulk) {
+    if (!bulk) {
+        transforms.reset();
+        return;
+    }
+    if (transforms)
+        return;
+
+    transforms.reset(new TransformStore());
+    for (auto &iter : objects)
+        transforms->add(iter.second.get());
+}
+
+bool GenEx::Layer::has_bulk_transforms() { return (bool)transforms; }
+
+bool GenEx::Layer::run_parallel(const std::function<bool(GenEx::Object*)> &fn) {
+    std::vector<GenEx::Object*> live;
+    live.reserve(objects.size());
+    for (auto &iter : objects) {
+        if (iter.second->is_dead())
+            has_dead = true;
+        else
+            live.push_back(iter.second.get());
+    }
+
+    std::atomic<bool> result(true);
+    Thread::GetJobPool().parallel_for(live.size(), parallel_grain,
+        [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+                if (!fn(live[i]))
+                    result.store(false);
+        });
+    return result.load();
+}
 
 std::string GenEx::Layer::add_object(std::shared_ptr<GenEx::Object> objptr, std::string name) {
     std::shared_ptr<GenEx::Object> object_to_add = objptr;
 
     // if the object is already in this layer, clone it
-    if (GenEx::Util::FindByValue(nullptr, objects, objptr)) {
+    if (get_object(objptr->get_id()) == objptr) {
         object_to_add = std::make_shared<GenEx::Object>(*objptr);
     }
 
     std::string name_to_use = name;
-    while (id_map.find(name_to_use) != id_map.end()) {
-        std::smatch matches;
-
-        // if a number isn't found at the end of the string, add one
-        if (!std::regex_search(name_to_use, matches, std::regex("(\\d+)(?!.*\\d)"))) {
-            name_to_use += "0";
-        } else {
-            // replace old number with new number
-            name_to_use = GenEx::Util::RegexReplace(name_to_use, "(\\d+)(?!.*\\d)", "");
-            name_to_use = std::to_string(std::stoi(matches[0])+1); // add new number
-        }
+    if (id_map.find(name_to_use) != id_map.end()) {
+        // "name" becomes "name0", "name5" becomes "name6"; the counter skips suffixes that
+        // were already handed out so bulk adds under one name don't rescan them
+        Uint64 suffix;
+        size_t split = GenEx::Util::SplitTrailingNumber(name, suffix);
+        std::string prefix = name.substr(0, split);
+        if (split < name.size())
+            suffix++;
+
+        Uint64 &counter = name_counters[prefix];
+        if (counter > suffix)
+            suffix = counter;
+        do {
+            name_to_use = prefix + std::to_string(suffix++);
+        } while (id_map.find(name_to_use) != id_map.end());
+        counter = suffix;
     }
 
-    id_map[name_to_use] = object_to_add->get_id();
-    objects[object_to_add->get_id()] = object_to_add;
+    mark_subtree_dirty();
+    hit_dirty = true;
+    insert_object(object_to_add, name_to_use);
 
     return name_to_use;
 }
 
-std::shared_ptr<GenEx::Object> GenEx::Layer::get_object(Uint64 num_id) {
-    auto iter = objects.find(num_id);
-    if (iter != objects.end()) {
+void GenEx::Layer::insert_object(std::shared_ptr<GenEx::Object> objptr, std::string name) {
+    Uint64 objid = objptr->get_id();
+    erase_object(objid);
+
+    // layers that are never rendered still need their stale entries dropped now & then
+    if (render_list.size() >= 2 * objects.size() + 64)
+        sort_render_list();
+
+    Util::SlotHandle handle = objects.insert(Entry(objid, objptr));
+    handles[objid] = handle;
+    render_list.push_back(RenderEntry{ handle, objptr->position[2], objptr->sort_key, objid });
+    adopt(objptr.get());
+    if (transforms)
+        transforms->add(objptr.get());
+    id_map[name] = objid;
+    name_map[objid] = name;
+}
+
+bool GenEx::Layer::is_stored(size_t index) {
+    auto iter = handles.find(objects[index].first);
+    return iter != handles.end() && iter->second == objects.handle_at(index);
+}
+
+bool GenEx::Layer::erase_object(Uint64 num_id) {
+    auto iter = handles.find(num_id);
+    if (iter == handles.end())
+        return false;
+
+    Entry *entry = objects.get(iter->second);
+    disown(entry->second.get());
+    if (transforms)
+        transforms->remove(entry->second.get());
+    if (traversals > 0)
+        pending_erase.push_back(iter->second); // erasing would move a child the walk hasn't seen
+    else
+        objects.erase(iter->second);
+    handles.erase(iter);
+
+    auto name = name_map.find(num_id);
+    if (name != name_map.end()) {
+        id_map.erase(name->second);
+        name_map.erase(name);
+    }
+    return true;
+}
+
+std::string GenEx::Layer::get_name(Uint64 num_id) {
+    auto iter = name_map.find(num_id);
+    if (iter != name_map.end())
         return iter->second;
+    return "";
+}
+
+std::shared_ptr<GenEx::Object> GenEx::Layer::get_object(Uint64 num_id) {
+    auto iter = handles.find(num_id);
+    if (iter != handles.end()) {
+        return objects.get(iter->second)->second;
     }
     return nullptr;
 }
@@ -384,7 +1024,7 @@ std::shared_ptr<GenEx::Object> GenEx::Layer::operator[] (Uint64 num_id) {
 std::shared_ptr<GenEx::Object> GenEx::Layer::get_object(std::string str_id) {
     auto iter = id_map.find(str_id);
     if (iter != id_map.end()) {
-        return objects[iter->second];
+        return get_object(iter->second);
     }
     return nullptr;
 }
@@ -393,98 +1033,277 @@ std::shared_ptr<GenEx::Object> GenEx::Layer::operator[] (std::string str_id) {
     return get_object(str_id);
 }
 
-std::unordered_map<Uint64, std::shared_ptr<GenEx::Object> >::const_iterator GenEx::Layer::begin()
-const { return objects.cbegin(); }
+GenEx::Util::SlotMap<GenEx::Layer::Entry>::const_iterator GenEx::Layer::begin() const {
+    return objects.cbegin();
+}
 
-std::unordered_map<Uint64, std::shared_ptr<GenEx::Object> >::const_iterator GenEx::Layer::end()
-const { return objects.cend(); }
+GenEx::Util::SlotMap<GenEx::Layer::Entry>::const_iterator GenEx::Layer::end() const {
+    return objects.cend();
+}
 
 void GenEx::Layer::remove_object(Uint64 num_id) {
-    if (objects.find(num_id) != objects.end()) {
-        objects.erase(num_id);
-        std::vector<std::string> vec;
-        GenEx::Util::FindByValue(vec, id_map, num_id);
-        id_map.erase(vec[0]);
+    if (erase_object(num_id)) {
+        mark_subtree_dirty();
+        hit_dirty = true;
     }
 }
 
 void GenEx::Layer::remove_object(std::string str_id) {
     auto iter = id_map.find(str_id);
     if (iter != id_map.end()) {
-        objects.erase(iter->second);
-        id_map.erase(iter);
+        erase_object(iter->second);
+        mark_subtree_dirty();
+        hit_dirty = true;
+    }
+}
+
+size_t GenEx::Layer::remove_objects(const std::vector<Uint64> &num_ids) {
+    size_t removed = 0;
+    for (Uint64 num_id : num_ids)
+        if (erase_object(num_id))
+            removed++;
+
+    if (removed > 0) {
+        mark_subtree_dirty();
+        hit_dirty = true;
     }
+    return removed;
+}
+
+void GenEx::Layer::destroy_objects(const std::vector<Uint64> &num_ids) {
+    for (Uint64 num_id : num_ids) {
+        auto iter = handles.find(num_id);
+        if (iter != handles.end()) {
+            objects.get(iter->second)->second->destroy();
+            has_dead = true;
+        }
+    }
+}
+
+size_t GenEx::Layer::remove_dead() {
+    // walk backwards; erasing swaps the last child into the hole, which was already checked
+    size_t removed = 0;
+    for (size_t i = objects.size(); i-- > 0;) {
+        if (objects[i].second->is_dead() && is_stored(i)) {
+            erase_object(objects[i].first);
+            removed++;
+        }
+    }
+    has_dead = false;
+
+    if (removed > 0) {
+        mark_subtree_dirty();
+        hit_dirty = true;
+    }
+    return removed;
 }
 
 void GenEx::Layer::remove_object(std::shared_ptr<GenEx::Object> &objptr) {
-    std::vector<Uint64> vec;
-    if (GenEx::Util::FindByValue(vec, objects, objptr)) {
-        objects.erase(vec[0]);
+    Uint64 objid = objptr->get_id();
+    if (get_object(objid) == objptr && erase_object(objid)) {
+        mark_subtree_dirty();
+        hit_dirty = true;
+    }
+}
 
-        std::vector<std::string> vec2;
-        GenEx::Util::FindByValue(vec2, id_map, vec[0]);
-        id_map.erase(vec2[0]);
+GenEx::Layer::TraversalGuard::TraversalGuard(GenEx::Layer *layer) : layer(layer) {
+    layer->traversals++;
+}
+
+GenEx::Layer::TraversalGuard::~TraversalGuard() {
+    if (--layer->traversals > 0 || (layer->graveyard.empty() && layer->pending_erase.empty()))
+        return;
+
+    // take them out first; freeing a child may start another traversal of this layer
+    std::vector< std::shared_ptr<GenEx::Object> > freed;
+    freed.swap(layer->graveyard);
+    for (auto handle : layer->pending_erase) {
+        GenEx::Layer::Entry *entry = layer->objects.get(handle);
+        if (entry != nullptr) {
+            freed.push_back(std::move(entry->second));
+            layer->objects.erase(handle);
+        }
     }
+    if (!layer->pending_erase.empty())
+        layer->hit_dirty = true; // the grid may have been rebuilt with them still in place
+    layer->pending_erase.clear();
 }
 
 // ------ LAYER EVENT HANDLERS --------------------------------------------------------------------
 
+void GenEx::Layer::sort_render_list() {
+    // erased children leave stale handles behind; squeeze them out while refreshing keys
+    size_t live = 0, disorder = 0;
+    for (size_t i = 0; i < render_list.size(); i++) {
+        RenderEntry entry = render_list[i];
+        Entry *child = objects.get(entry.handle);
+        if (child == nullptr)
+            continue;
+
+        entry.z = child->second->position[2];
+        entry.sort_key = child->second->sort_key;
+        if (live > 0 && entry < render_list[live - 1])
+            disorder++;
+        render_list[live++] = entry;
+    }
+    render_list.resize(live);
+
+    // a big batch of new children or a reshuffle would make the insertion sort quadratic
+    if (disorder > live / RENDER_SORT_DISORDER) {
+        std::stable_sort(render_list.begin(), render_list.end());
+        return;
+    }
+
+    for (size_t i = 1; i < render_list.size(); i++) {
+        if (!(render_list[i] < render_list[i - 1]))
+            continue;
+
+        RenderEntry entry = render_list[i];
+        size_t j = i;
+        do {
+            render_list[j] = render_list[j - 1];
+            j--;
+        } while (j > 0 && entry < render_list[j - 1]);
+        render_list[j] = entry;
+    }
+}
+
 void GenEx::Layer::render(SDL_Renderer *target, int offset_x, int offset_y, int offset_z) {
     Object::render(target, offset_x, offset_y, offset_z);
-    for (auto iter : objects)
-        if (!iter.second->is_dead()) {
-            remove_object(iter.second);
+
+    sort_render_list();
+
+    // the outermost layer places itself; every other one was placed by its parent
+    if (render_depth == 0) {
+        GenEx::WorldTransform root;
+        root.x0 = offset_x;
+        root.y0 = offset_y;
+        root.z0 = offset_z;
+        refresh_world_transform(root, 0);
+    }
+    render_depth++;
+
+    const GenEx::WorldTransform &world = get_world_transform();
+    Uint64 version = get_world_version();
+    int x = (int)std::lround(world.x0), y = (int)std::lround(world.y0);
+    int z = (int)std::lround(world.z0);
+    TraversalGuard guard(this);
+    for (size_t i = 0; i < render_list.size(); i++) {
+        Entry *child = objects.get(render_list[i].handle);
+        if (child == nullptr)
+            continue;
+
+        GenEx::Object *objptr = child->second.get();
+        if (objptr->is_dead())
+            has_dead = true; // swept by the next update
+        else {
+            objptr->refresh_world_transform(world, version);
+            objptr->render(target, x, y, z);
         }
-        else
-            iter.second->render(target,
-                                position[0] + offset_x,
-                                position[1] + offset_y,
-                                position[2] + offset_z);
+    }
+
+    render_depth--;
 
     SDL_SetRenderTarget(target, nullptr);
 }
 
 bool GenEx::Layer::update(double elapsed) {
-    for (auto iter : objects) {
-        if (iter.second->is_dead()) {
-            remove_object(iter.second);
+    hit_moved = true; // children are about to move; refiled before the next pointer event
+
+    if (transforms)
+        transforms->integrate(elapsed);
+
+    bool result = true;
+    TraversalGuard guard(this);
+    if (parallel && objects.size() > parallel_grain) {
+        if (transforms)
+            transforms->scatter();
+        result = run_parallel([elapsed](GenEx::Object *obj) { return obj->update(elapsed); });
+    }
+    else {
+        // dead children are only marked here; removing mid-walk would shuffle the storage
+        for (size_t i = 0; i < objects.size(); i++) {
+            GenEx::Object *child = objects[i].second.get();
+            if (child->is_dead()) {
+                has_dead = true;
+                continue;
+            }
+
+            // copy the results out while the child is in cache anyway; children that were
+            // moved in bulk & have no update handler of their own are done after that
+            if (transforms && transforms->scatter(child) &&
+                    !(child->get_event_mask() & Events::MASK_UPDATE))
+                continue;
+
+            if (!(child->update(elapsed))) {
+                result = false;
+                break;
+            }
         }
-        else if (!(iter.second->update(elapsed)))
-            return false;
     }
-    return Object::update(elapsed);
+
+    // children that died this step, or since the last sweep, go in one batch
+    if (has_dead)
+        remove_dead();
+    return result && Object::update(elapsed);
 }
 
 bool GenEx::Layer::targetreset() {
-    for (auto iter : objects) {
-        if (iter.second->is_dead()) {
-            remove_object(iter.second);
+    bool result = true;
+    TraversalGuard guard(this);
+    if (parallel && objects.size() > parallel_grain)
+        result = run_parallel([](GenEx::Object *obj) {
+            return !(obj->get_event_mask() & Events::MASK_TARGETRESET) || obj->targetreset();
+        });
+    else {
+        for (size_t i = 0; i < objects.size(); i++) {
+            GenEx::Object *child = objects[i].second.get();
+            if (child->is_dead())
+                has_dead = true;
+            else if ((child->get_event_mask() & Events::MASK_TARGETRESET) &&
+                     !(child->targetreset())) {
+                result = false;
+                break;
+            }
         }
-        else if (!(iter.second->targetreset()))
-            return false;
     }
-    return Object::targetreset();
+
+    if (has_dead)
+        remove_dead();
+    return result && Object::targetreset();
 }
 
 bool GenEx::Layer::windowevent(Uint8 event, Sint32 data1, Sint32 data2) {
-    for (auto iter : objects) {
-        if (!(iter.second->windowevent(event, data1, data2)))
+    TraversalGuard guard(this);
+    for (size_t i = 0; i < objects.size(); i++) {
+        GenEx::Object *child = objects[i].second.get();
+        if (!(child->get_event_mask() & Events::MASK_WINDOWEVENT))
+            continue;
+        if (!(child->windowevent(event, data1, data2)))
             return false;
     }
     return Object::windowevent(event, data1, data2);
 }
 
 bool GenEx::Layer::keydown(SDL_Keycode key, SDL_Scancode scancode, Uint16 mod, Uint8 repeat) {
-    for (auto iter : objects) {
-        if (!(iter.second->keydown(key, scancode, mod, repeat)))
+    TraversalGuard guard(this);
+    for (size_t i = 0; i < objects.size(); i++) {
+        GenEx::Object *child = objects[i].second.get();
+        if (!(child->get_event_mask() & Events::MASK_KEYDOWN))
+            continue;
+        if (!(child->keydown(key, scancode, mod, repeat)))
             return false;
     }
     return Object::keydown(key, scancode, mod, repeat);
 }
 
 bool GenEx::Layer::keyup(SDL_Keycode key, SDL_Scancode scancode, Uint16 mod, Uint8 repeat) {
-    for (auto iter : objects) {
-        if (!(iter.second->keyup(key, scancode, mod, repeat)))
+    TraversalGuard guard(this);
+    for (size_t i = 0; i < objects.size(); i++) {
+        GenEx::Object *child = objects[i].second.get();
+        if (!(child->get_event_mask() & Events::MASK_KEYUP))
+            continue;
+        if (!(child->keyup(key, scancode, mod, repeat)))
             return false;
     }
     return Object::keyup(key, scancode, mod, repeat);
@@ -492,153 +1311,217 @@ bool GenEx::Layer::keyup(SDL_Keycode key, SDL_Scancode scancode, Uint16 mod, Uin
 
 bool GenEx::Layer::textediting(char text[SDL_TEXTEDITINGEVENT_TEXT_SIZE],
                                Sint32 start, Sint32 length) {
-    for (auto iter : objects) {
-        if (!(iter.second->textediting(text, start, length)))
+    TraversalGuard guard(this);
+    for (size_t i = 0; i < objects.size(); i++) {
+        GenEx::Object *child = objects[i].second.get();
+        if (!(child->get_event_mask() & Events::MASK_TEXTEDITING))
+            continue;
+        if (!(child->textediting(text, start, length)))
             return false;
     }
     return Object::textediting(text, start, length);
 }
 
 bool GenEx::Layer::textinput(char text[SDL_TEXTINPUTEVENT_TEXT_SIZE]) {
-    for (auto iter : objects) {
-        if (!(iter.second->textinput(text)))
+    TraversalGuard guard(this);
+    for (size_t i = 0; i < objects.size(); i++) {
+        GenEx::Object *child = objects[i].second.get();
+        if (!(child->get_event_mask() & Events::MASK_TEXTINPUT))
+            continue;
+        if (!(child->textinput(text)))
             return false;
     }
     return Object::textinput(text);
 }
 
 bool GenEx::Layer::mousedown(Sint32 x, Sint32 y, Uint8 button, Uint8 clicks, Uint32 which) {
-    for (auto iter : objects) {
-        if (!(iter.second->mousedown(x, y, button, clicks, which)))
-            return false;
-    }
+    if (!dispatch_pointer(x, y, Events::MASK_MOUSEDOWN, [&](GenEx::Object *obj) {
+                return obj->mousedown(x, y, button, clicks, which);
+            }))
+        return false;
     return Object::mousedown(x, y, button, clicks, which);
 }
 
 bool GenEx::Layer::mouseup(Sint32 x, Sint32 y, Uint8 button, Uint8 clicks, Uint32 which) {
-    for (auto iter : objects) {
-        if (!(iter.second->mouseup(x, y, button, clicks, which)))
-            return false;
-    }
+    if (!dispatch_pointer(x, y, Events::MASK_MOUSEUP, [&](GenEx::Object *obj) {
+                return obj->mouseup(x, y, button, clicks, which);
+            }))
+        return false;
     return Object::mouseup(x, y, button, clicks, which);
 }
 
 bool GenEx::Layer::mousemotion(Sint32 x, Sint32 y, Sint32 xrel, Sint32 yrel,
                                bool buttons[5], Uint32 which) {
-    for (auto iter : objects) {
-        if (!(iter.second->mousemotion(x, y, xrel, yrel, buttons, which)))
-            return false;
-    }
+    if (!dispatch_pointer(x, y, Events::MASK_MOUSEMOTION, [&](GenEx::Object *obj) {
+                return obj->mousemotion(x, y, xrel, yrel, buttons, which);
+            }))
+        return false;
     return Object::mousemotion(x, y, xrel, yrel, buttons, which);
 }
 
 bool GenEx::Layer::mousewheel(bool flipped, Sint32 x, Sint32 y, Uint32 which) {
-    for (auto iter : objects) {
-        if (!(iter.second->mousewheel(flipped, x, y, which)))
+    TraversalGuard guard(this);
+    for (size_t i = 0; i < objects.size(); i++) {
+        GenEx::Object *child = objects[i].second.get();
+        if (!(child->get_event_mask() & Events::MASK_MOUSEWHEEL))
+            continue;
+        if (!(child->mousewheel(flipped, x, y, which)))
             return false;
     }
     return Object::mousewheel(flipped, x, y, which);
 }
 
 bool GenEx::Layer::clipboardupdate(char text[]) {
-    for (auto iter : objects) {
-        if (!(iter.second->clipboardupdate(text)))
+    TraversalGuard guard(this);
+    for (size_t i = 0; i < objects.size(); i++) {
+        GenEx::Object *child = objects[i].second.get();
+        if (!(child->get_event_mask() & Events::MASK_CLIPBOARDUPDATE))
+            continue;
+        if (!(child->clipboardupdate(text)))
             return false;
     }
     return Object::clipboardupdate(text);
 }
 
 bool GenEx::Layer::filedrop(std::string filename) {
-    for (auto iter : objects) {
-        if (!(iter.second->filedrop(filename)))
+    TraversalGuard guard(this);
+    for (size_t i = 0; i < objects.size(); i++) {
+        GenEx::Object *child = objects[i].second.get();
+        if (!(child->get_event_mask() & Events::MASK_FILEDROP))
+            continue;
+        if (!(child->filedrop(filename)))
             return false;
     }
     return Object::filedrop(filename);
 }
 
 bool GenEx::Layer::textdrop(char text[]) {
-    for (auto iter : objects) {
-        if (!(iter.second->textdrop(text)))
+    TraversalGuard guard(this);
+    for (size_t i = 0; i < objects.size(); i++) {
+        GenEx::Object *child = objects[i].second.get();
+        if (!(child->get_event_mask() & Events::MASK_TEXTDROP))
+            continue;
+        if (!(child->textdrop(text)))
             return false;
     }
     return Object::textdrop(text);
 }
 
 bool GenEx::Layer::begindrop() {
-    for (auto iter : objects) {
-        if (!(iter.second->begindrop()))
+    TraversalGuard guard(this);
+    for (size_t i = 0; i < objects.size(); i++) {
+        GenEx::Object *child = objects[i].second.get();
+        if (!(child->get_event_mask() & Events::MASK_BEGINDROP))
+            continue;
+        if (!(child->begindrop()))
             return false;
     }
     return Object::begindrop();
 }
 
 bool GenEx::Layer::completedrop() {
-    for (auto iter : objects) {
-        if (!(iter.second->completedrop()))
+    TraversalGuard guard(this);
+    for (size_t i = 0; i < objects.size(); i++) {
+        GenEx::Object *child = objects[i].second.get();
+        if (!(child->get_event_mask() & Events::MASK_COMPLETEDROP))
+            continue;
+        if (!(child->completedrop()))
             return false;
     }
     return Object::completedrop();
 }
 
 bool GenEx::Layer::jaxis(SDL_JoystickID joystick_id, Uint8 axis, Sint16 value) {
-    for (auto iter : objects) {
-        if (!(iter.second->jaxis(joystick_id, axis, value)))
+    TraversalGuard guard(this);
+    for (size_t i = 0; i < objects.size(); i++) {
+        GenEx::Object *child = objects[i].second.get();
+        if (!(child->get_event_mask() & Events::MASK_JAXIS))
+            continue;
+        if (!(child->jaxis(joystick_id, axis, value)))
             return false;
     }
     return Object::jaxis(joystick_id, axis, value);
 }
 
 bool GenEx::Layer::jball(SDL_JoystickID joystick_id, Uint8 ball, Sint16 x, Sint16 y) {
-    for (auto iter : objects) {
-        if (!(iter.second->jball(joystick_id, ball, x, y)))
+    TraversalGuard guard(this);
+    for (size_t i = 0; i < objects.size(); i++) {
+        GenEx::Object *child = objects[i].second.get();
+        if (!(child->get_event_mask() & Events::MASK_JBALL))
+            continue;
+        if (!(child->jball(joystick_id, ball, x, y)))
             return false;
     }
     return Object::jball(joystick_id, ball, x, y);
 }
 
 bool GenEx::Layer::jhat(SDL_JoystickID joystick_id, Uint8 hat, Uint8 value) {
-    for (auto iter : objects) {
-        if (!(iter.second->jhat(joystick_id, hat, value)))
+    TraversalGuard guard(this);
+    for (size_t i = 0; i < objects.size(); i++) {
+        GenEx::Object *child = objects[i].second.get();
+        if (!(child->get_event_mask() & Events::MASK_JHAT))
+            continue;
+        if (!(child->jhat(joystick_id, hat, value)))
             return false;
     }
     return Object::jhat(joystick_id, hat, value);
 }
 
 bool GenEx::Layer::jbtndown(SDL_JoystickID joystick_id, Uint8 button) {
-    for (auto iter : objects) {
-        if (!(iter.second->jbtndown(joystick_id, button)))
+    TraversalGuard guard(this);
+    for (size_t i = 0; i < objects.size(); i++) {
+        GenEx::Object *child = objects[i].second.get();
+        if (!(child->get_event_mask() & Events::MASK_JBTNDOWN))
+            continue;
+        if (!(child->jbtndown(joystick_id, button)))
             return false;
     }
     return Object::jbtndown(joystick_id, button);
 }
 
 bool GenEx::Layer::jbtnup(SDL_JoystickID joystick_id, Uint8 button) {
-    for (auto iter : objects) {
-        if (!(iter.second->jbtnup(joystick_id, button)))
+    TraversalGuard guard(this);
+    for (size_t i = 0; i < objects.size(); i++) {
+        GenEx::Object *child = objects[i].second.get();
+        if (!(child->get_event_mask() & Events::MASK_JBTNUP))
+            continue;
+        if (!(child->jbtnup(joystick_id, button)))
             return false;
     }
     return Object::jbtnup(joystick_id, button);
 }
 
 bool GenEx::Layer::caxis(SDL_JoystickID controller_id, Uint8 axis, Sint16 value) {
-    for (auto iter : objects) {
-        if (!(iter.second->caxis(controller_id, axis, value)))
+    TraversalGuard guard(this);
+    for (size_t i = 0; i < objects.size(); i++) {
+        GenEx::Object *child = objects[i].second.get();
+        if (!(child->get_event_mask() & Events::MASK_CAXIS))
+            continue;
+        if (!(child->caxis(controller_id, axis, value)))
             return false;
     }
     return Object::caxis(controller_id, axis, value);
 }
 
 bool GenEx::Layer::cbtndown(SDL_JoystickID controller_id, Uint8 button) {
-    for (auto iter : objects) {
-        if (!(iter.second->cbtndown(controller_id, button)))
+    TraversalGuard guard(this);
+    for (size_t i = 0; i < objects.size(); i++) {
+        GenEx::Object *child = objects[i].second.get();
+        if (!(child->get_event_mask() & Events::MASK_CBTNDOWN))
+            continue;
+        if (!(child->cbtndown(controller_id, button)))
             return false;
     }
     return Object::cbtndown(controller_id, button);
 }
 
 bool GenEx::Layer::cbtnup(SDL_JoystickID controller_id, Uint8 button) {
-    for (auto iter : objects) {
-        if (!(iter.second->cbtnup(controller_id, button)))
+    TraversalGuard guard(this);
+    for (size_t i = 0; i < objects.size(); i++) {
+        GenEx::Object *child = objects[i].second.get();
+        if (!(child->get_event_mask() & Events::MASK_CBTNUP))
+            continue;
+        if (!(child->cbtnup(controller_id, button)))
             return false;
     }
     return Object::cbtnup(controller_id, button);
@@ -646,35 +1529,45 @@ bool GenEx::Layer::cbtnup(SDL_JoystickID controller_id, Uint8 button) {
 
 bool GenEx::Layer::fingerdown(SDL_TouchID touch_id, SDL_FingerID finger_id, float x, float y,
                               float pressure) {
-    for (auto iter : objects) {
-        if (!(iter.second->fingerdown(touch_id, finger_id, x, y, pressure)))
-            return false;
-    }
+    SDL_Point viewport = GetViewportSize();
+    if (!dispatch_pointer(x * viewport.x, y * viewport.y, Events::MASK_FINGERDOWN,
+            [&](GenEx::Object *obj) {
+                return obj->fingerdown(touch_id, finger_id, x, y, pressure);
+            }))
+        return false;
     return Object::fingerdown(touch_id, finger_id, x, y, pressure);
 }
 
 bool GenEx::Layer::fingerup(SDL_TouchID touch_id, SDL_FingerID finger_id, float x, float y,
                             float pressure) {
-    for (auto iter : objects) {
-        if (!(iter.second->fingerup(touch_id, finger_id, x, y, pressure)))
-            return false;
-    }
+    SDL_Point viewport = GetViewportSize();
+    if (!dispatch_pointer(x * viewport.x, y * viewport.y, Events::MASK_FINGERUP,
+            [&](GenEx::Object *obj) {
+                return obj->fingerup(touch_id, finger_id, x, y, pressure);
+            }))
+        return false;
     return Object::fingerup(touch_id, finger_id, x, y, pressure);
 }
 
 bool GenEx::Layer::fingermotion(SDL_TouchID touch_id, SDL_FingerID finger_id, float x, float y,
                                 float dx, float dy, float pressure) {
-    for (auto iter : objects) {
-        if (!(iter.second->fingermotion(touch_id, finger_id, x, y, dx, dy, pressure)))
-            return false;
-    }
+    SDL_Point viewport = GetViewportSize();
+    if (!dispatch_pointer(x * viewport.x, y * viewport.y, Events::MASK_FINGERMOTION,
+            [&](GenEx::Object *obj) {
+                return obj->fingermotion(touch_id, finger_id, x, y, dx, dy, pressure);
+            }))
+        return false;
     return Object::fingermotion(touch_id, finger_id, x, y, dx, dy, pressure);
 }
 
 bool GenEx::Layer::gesturerecord(SDL_TouchID touch_id, SDL_GestureID gesture_id,
                                  Uint32 num_fingers, float x, float y) {
-    for (auto iter : objects) {
-        if (!(iter.second->gesturerecord(touch_id, gesture_id, num_fingers, x, y)))
+    TraversalGuard guard(this);
+    for (size_t i = 0; i < objects.size(); i++) {
+        GenEx::Object *child = objects[i].second.get();
+        if (!(child->get_event_mask() & Events::MASK_GESTURERECORD))
+            continue;
+        if (!(child->gesturerecord(touch_id, gesture_id, num_fingers, x, y)))
             return false;
     }
     return Object::gesturerecord(touch_id, gesture_id, num_fingers, x, y);
@@ -682,8 +1575,12 @@ bool GenEx::Layer::gesturerecord(SDL_TouchID touch_id, SDL_GestureID gesture_id,
 
 bool GenEx::Layer::gestureperform(SDL_TouchID touch_id, SDL_GestureID gesture_id,
                                   Uint32 num_fingers, float x, float y, float error) {
-    for (auto iter : objects) {
-        if (!(iter.second->gestureperform(touch_id, gesture_id, num_fingers, x, y, error)))
+    TraversalGuard guard(this);
+    for (size_t i = 0; i < objects.size(); i++) {
+        GenEx::Object *child = objects[i].second.get();
+        if (!(child->get_event_mask() & Events::MASK_GESTUREPERFORM))
+            continue;
+        if (!(child->gestureperform(touch_id, gesture_id, num_fingers, x, y, error)))
             return false;
     }
     return Object::gestureperform(touch_id, gesture_id, num_fingers, x, y, error);
@@ -691,16 +1588,24 @@ bool GenEx::Layer::gestureperform(SDL_TouchID touch_id, SDL_GestureID gesture_id
 
 bool GenEx::Layer::multigesture(SDL_TouchID touch_id, Uint16 num_fingers, float x, float y,
                                 float d_theta, float d_dist) {
-   for (auto iter : objects) {
-        if (!(iter.second->multigesture(touch_id, num_fingers, x, y, d_theta, d_dist)))
+    TraversalGuard guard(this);
+    for (size_t i = 0; i < objects.size(); i++) {
+        GenEx::Object *child = objects[i].second.get();
+        if (!(child->get_event_mask() & Events::MASK_MULTIGESTURE))
+            continue;
+        if (!(child->multigesture(touch_id, num_fingers, x, y, d_theta, d_dist)))
             return false;
     }
     return Object::multigesture(touch_id, num_fingers, x, y, d_theta, d_dist);
 }
 
 bool GenEx::Layer::userevent(Sint32 code, void *data1, void *data2) {
-    for (auto iter : objects) {
-        if (!(iter.second->userevent(code, data1, data2)))
+    TraversalGuard guard(this);
+    for (size_t i = 0; i < objects.size(); i++) {
+        GenEx::Object *child = objects[i].second.get();
+        if (!(child->get_event_mask() & Events::MASK_USEREVENT))
+            continue;
+        if (!(child->userevent(code, data1, data2)))
             return false;
     }
     return Object::userevent(code, data1, data2);
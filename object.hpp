@@ -30,12 +30,88 @@
 
 #include "base.hpp"
 #include "events.hpp"
+#include "util/slotmap.hpp"
+#include "components.hpp"
 
 namespace GenEx {
+    class Layer;
 
 // --- OBJECT CLASS -------------------------------------------------------------------------------
 
+    /** \brief An axis-aligned rectangle in the coordinate space of an object's Layer
+     */
+    struct Bounds {
+        double x, y; // top-left corner
+        double w, h;
+
+        /** \brief Returns whether or not a point lies inside this rectangle.
+         *
+         * \param double <u>px</u>: X-position of the point
+         * \param double <u>py</u>: Y-position of the point
+         * \return bool TRUE if the point is inside
+         *
+         */
+        bool contains(double px, double py) const {
+            return px >= x && px < x + w && py >= y && py < y + h;
+        }
+    };
+
+    /** \brief A 2D affine transform plus a depth offset, taking an object's local coordinates
+     *        to window coordinates.
+     *
+     * Layers only hand their children the translation, as the integer offsets render() gets,
+     * & hit-test against it too; a parent's rotation & scale don't turn or stretch what its
+     * children draw. Render handlers that want them can read get_world_transform().
+     */
+    struct WorldTransform {
+        double xx = 1, xy = 0; // x' = xx * x + xy * y + x0
+        double yx = 0, yy = 1; // y' = yx * x + yy * y + y0
+        double x0 = 0, y0 = 0;
+        double z0 = 0;
+
+        /** \brief Transforms a point in place.
+         *
+         * \param double &<u>x</u>: X-position of the point
+         * \param double &<u>y</u>: Y-position of the point
+         *
+         */
+        void apply(double &x, double &y) const {
+            double tx = xx * x + xy * y + x0;
+            y = yx * x + yy * y + y0;
+            x = tx;
+        }
+
+        /** \brief Composes this transform with one applied before it.
+         *
+         * \param WorldTransform &<u>local</u>: The transform applied first
+         * \return WorldTransform This transform after <u>local</u>
+         *
+         */
+        WorldTransform operator* (const WorldTransform &local) const {
+            WorldTransform out;
+            out.xx = xx * local.xx + xy * local.yx;
+            out.xy = xx * local.xy + xy * local.yy;
+            out.yx = yx * local.xx + yy * local.yx;
+            out.yy = yx * local.xy + yy * local.yy;
+            out.x0 = xx * local.x0 + xy * local.y0 + x0;
+            out.y0 = yx * local.x0 + yy * local.y0 + y0;
+            out.z0 = z0 + local.z0;
+            return out;
+        }
+
+        bool operator== (const WorldTransform &other) const {
+            return xx == other.xx && xy == other.xy && yx == other.yx && yy == other.yy &&
+                   x0 == other.x0 && y0 == other.y0 && z0 == other.z0;
+        }
+        bool operator!= (const WorldTransform &other) const { return !(*this == other); }
+    };
+
     /** \brief The base object class for GenEx.
+     *
+     * Layers only pass an event kind to children whose get_event_mask() includes it. A plain
+     * Object's mask comes from its EventHandlers. A subclass that overrides handler virtuals
+     * is sent every event kind until it calls subscribe(); once it has, it only gets the kinds
+     * in its handlers & the ones it subscribed to.
      */
     class Object {
     public:
@@ -46,16 +122,90 @@ namespace GenEx {
         Math::Vector3 rotation; // rotation values
         Math::Vector3 scale; // scaling values
 
-        Math::Vector3 move_vector;
-        Math::Vector3 angle_vector;
+        Math::Vector3 move_vector; // movement per 1/60th of a second
+        Math::Vector3 angle_vector; // rotation per 1/60th of a second
+
+        Sint32 sort_key = 0; // draw order among objects at the same depth; lower draws first
+
+    protected:
+        Math::Vector3 prev_position; // position as of the previous update
+        Math::Vector3 prev_rotation; // rotation as of the previous update
+        bool integrated = false; // FALSE until the first update; drawn where it is until then
 
     private:
         Uint64 instance_id;
         static Uint64 _num_instances;
         bool dead = false;
 
+        static thread_local double interpolation;
+        static thread_local int viewport_w, viewport_h;
+
+        double bounds_w = 0, bounds_h = 0; // unscaled size used for hit-testing
+        bool bounded = false;
+        bool opaque = false;
+
+        /** \brief Places this object's bounding box as if it were drawn at a point.
+         *
+         * \param double <u>x</u>: X-coordinate the object is drawn at, offset included
+         * \param double <u>y</u>: Y-coordinate the object is drawn at, offset included
+         * \return Bounds The bounding box around that point
+         *
+         */
+        Bounds place_bounds(double x, double y);
+
+        Events::EventMask event_mask; // event kinds this object handles itself
+        bool subscribed = false; // subscribe() was called, so event_mask is complete
+        bool mask_open = false; // a subclass that never subscribed; may handle anything
+        std::vector<Layer*> parents; // layers holding this object; told when its mask changes
+
+        TransformStore *transform_store = nullptr; // integrates this object in bulk if set
+        size_t transform_row = 0;
+
+        // cached local -> window transform; rebuilt only when something feeding it changed
+        WorldTransform world;
+        Uint64 world_version = 0; // bumped whenever world actually changes
+        Uint64 parent_version = ~(Uint64)0; // parent's world_version world was built from
+        bool transform_dirty = true; // rebuild world even if nothing seems to have changed
+        double world_inputs[8] = {}; // own values world was built from; see refresh_world_transform
+        static std::atomic<Uint64> world_clock; // hands out world versions
+
+        friend class TransformStore;
+        friend class Layer;
+
+        void set_handler_table(const Events::HandlerTable *table);
+        void add_event_mask(Events::EventMask mask);
+
     protected:
-        Events::EventHandlers event_handlers;
+        const Events::HandlerTable *handler_table; // interned; shared with equal objects
+
+        /** \brief Constructor with an already interned table of event handlers.
+         *
+         * \param Events::HandlerTable *<u>table</u>: Table from Events::InternEventHandlers()
+         *
+         */
+        Object(const Events::HandlerTable *table);
+
+        /** \brief Marks event kinds as handled by this object. A subclass that calls this
+         *        (even with <i>Events::MASK_NONE</i>) is only sent the kinds in its handlers &
+         *        the ones it subscribed to; one that never does is sent everything.
+         *
+         * \param Events::EventMask <u>mask</u>: The event kinds to add
+         *
+         */
+        void subscribe(Events::EventMask mask);
+
+        /** \brief Tells the layers holding this object, & theirs in turn, that their cached
+         *        subtree masks may be out of date.
+         */
+        void invalidate_event_mask();
+
+        /** \brief Moves this object along its move & angle vectors by one simulation step;
+         *        the part of update() that runs before the update handler.
+         *
+         * \param double <u>elapsed</u>: The length of the step in seconds
+         *
+         */
+        void integrate(double elapsed);
 
     public:
 // ------ OBJECT CONSTRUCTORS ---------------------------------------------------------------------
@@ -132,6 +282,182 @@ namespace GenEx {
          */
         virtual Object *clone();
 
+        /** \brief Gets the event kinds this object (and anything inside it) handles.
+         *
+         * \return Events::EventMask Bits set for every handled event kind
+         *
+         */
+        virtual Events::EventMask get_event_mask();
+
+        /** \brief Gets the event handlers this object uses.
+         *
+         * \return Events::EventHandlers& The handlers; shared with other objects, read only
+         *
+         */
+        const Events::EventHandlers &get_event_handlers();
+
+        /** \brief Switches this object over to a different set of event handlers. The init
+         *        handler is not run again.
+         *
+         * \param Events::EventHandlers &<u>evt_handlers</u>: The event handlers to use
+         *
+         */
+        void set_event_handlers(const Events::EventHandlers &evt_handlers);
+
+        /** \brief Overrides a single event handler, leaving every other object that shares
+         *        this object's handlers alone.
+         *
+         * \param F Events::EventHandlers::*<u>member</u>: The handler to replace, e.g.
+         *        <i>&Events::EventHandlers::keydown</i>
+         * \param F <u>handler</u>: The new handler
+         *
+         */
+        template <typename F>
+        void set_event_handler(F Events::EventHandlers::*member, F handler) {
+            set_handler_table(Events::ReplaceEventHandler(handler_table, member, handler));
+        }
+
+        /** \brief Returns whether or not this object's motion is integrated by a
+         *        TransformStore instead of its own update().
+         *
+         * \return bool TRUE if the object is in a transform store
+         *
+         */
+        bool in_transform_store();
+
+        /** \brief Pushes changes made directly to <i>position</i>, <i>rotation</i>,
+         *        <i>move_vector</i> or <i>angle_vector</i> into this object's
+         *        transform store right away; otherwise the next bulk pass picks them up. Does
+         *        nothing if the object isn't in a store.
+         */
+        void commit_transform();
+
+// ------ WORLD TRANSFORMS ------------------------------------------------------------------------
+
+        /** \brief Makes this object rebuild its world transform before the next render even
+         *        if nothing feeding it seems to have changed. Changes to <i>position</i>,
+         *        <i>anchor_point</i>, <i>offset</i>, <i>rotation</i> & <i>scale</i> are noticed
+         *        without it.
+         */
+        void mark_transform_dirty();
+
+        /** \brief Rebuilds this object's world transform if its parent's or any of its own
+         *        values feeding it changed since it was last built; resting objects cost a few
+         *        comparisons. Layers call this on their children before rendering them.
+         *
+         * \param WorldTransform &<u>parent</u>: The world transform of the containing layer
+         * \param Uint64 <u>parent_version</u>: The containing layer's world version
+         *
+         */
+        void refresh_world_transform(const WorldTransform &parent, Uint64 parent_version);
+
+        /** \brief Gets the transform from this object's local coordinates to window
+         *        coordinates as of the last render: the parent's, then <i>position</i> +
+         *        <i>offset</i>, <i>rotation</i> (z, degrees), <i>scale</i>, and
+         *        <i>anchor_point</i> against the hit-testing bounds.
+         *
+         * \return WorldTransform& The cached world transform
+         *
+         */
+        const WorldTransform &get_world_transform();
+
+        /** \brief Gets a number that changes whenever this object's world transform does.
+         *
+         * \return Uint64 The world version
+         *
+         */
+        Uint64 get_world_version();
+
+// ------ INTERPOLATION ---------------------------------------------------------------------------
+
+        /** \brief Sets how far between the previous and the current update objects rendered on
+         *        the calling thread should be drawn.
+         *
+         * \param double <u>alpha</u>: 0.0 for the previous update; 1.0 for the current one
+         *
+         */
+        static void SetInterpolation(double alpha);
+
+        /** \brief Gets how far between the previous and the current update objects rendered on
+         *        the calling thread are being drawn.
+         *
+         * \return double 0.0 for the previous update; 1.0 for the current one
+         *
+         */
+        static double GetInterpolation();
+
+        /** \brief Gets the position this object should be drawn at this frame.
+         *
+         * \return Math::Vector3 The position interpolated between the last two updates; just
+         *         the position if the object hasn't been updated yet
+         *
+         */
+        Math::Vector3 get_render_position();
+
+        /** \brief Gets the rotation this object should be drawn with this frame.
+         *
+         * \return Math::Vector3 The rotation interpolated between the last two updates; just
+         *         the rotation if the object hasn't been updated yet
+         *
+         */
+        Math::Vector3 get_render_rotation();
+
+// ------ HIT-TESTING -----------------------------------------------------------------------------
+
+        /** \brief Gives this object a size so Layers only send it pointer events that land on
+         *        it. The box is placed where the object is drawn, using get_render_position(),
+         *        <i>offset</i>, <i>anchor_point</i> & <i>scale</i>.
+         *
+         * \param double <u>w</u>: Unscaled width
+         * \param double <u>h</u>: Unscaled height
+         * \param bool <u><i>opaque</i></u>: TRUE to keep objects behind this one from getting
+         *        pointer events that hit it; defaults to FALSE
+         *
+         */
+        void set_bounds(double w, double h, bool opaque = false);
+
+        /** \brief Removes this object's bounds so it gets every pointer event again.
+         */
+        void clear_bounds();
+
+        /** \brief Returns whether or not this object has bounds.
+         *
+         * \return bool TRUE if set_bounds() was called
+         *
+         */
+        bool has_bounds();
+
+        /** \brief Returns whether or not this object blocks pointer events for those behind it.
+         *
+         * \return bool TRUE if the object is opaque
+         *
+         */
+        bool is_opaque();
+
+        /** \brief Gets where this object sits in its Layer's coordinate space as of the last
+         *        render: its interpolated position plus <i>offset</i>, as render() uses.
+         *
+         * \return Bounds The object's bounding box
+         *
+         */
+        Bounds get_bounds();
+
+        /** \brief Sets the size touch coordinates are scaled to on the calling thread. Windows
+         *        set this before handing out finger events.
+         *
+         * \param int <u>w</u>: Viewport width
+         * \param int <u>h</u>: Viewport height
+         *
+         */
+        static void SetViewportSize(int w, int h);
+
+        /** \brief Gets the size touch coordinates are scaled to on the calling thread.
+         *
+         * \return SDL_Point Viewport width & height
+         *
+         */
+        static SDL_Point GetViewportSize();
+
 // ------ OBJECT EVENT HANDLERS -------------------------------------------------------------------
 
         /** \brief Renders this object on to a target.
@@ -144,9 +470,9 @@ namespace GenEx {
          */
         virtual void render(SDL_Renderer *target, int offset_x, int offset_y, int offset_z);
 
-        /** \brief Updates the object.
+        /** \brief Updates the object by one simulation step.
          *
-         * \param double <elapsed>: The elapsed time since the previous frame in seconds
+         * \param double <elapsed>: The length of the step in seconds
          * \return bool TRUE to continue running the application
          *
          */
@@ -491,12 +817,179 @@ namespace GenEx {
 
 // --- LAYER CLASS --------------------------------------------------------------------------------
 
+    /** \brief The default size of the cells in a Layer's hit-testing grid
+     */
+    const double DEFAULT_HIT_CELL_SIZE = 64.0;
+
+    /** \brief Children covering more grid cells than this are tested for every pointer event
+     */
+    const long MAX_HIT_CELLS = 64;
+
+    /** \brief How many children a parallel Layer hands to each job by default
+     */
+    const size_t DEFAULT_PARALLEL_GRAIN = 64;
+
+    /** \brief A Layer's render list is fully re-sorted, rather than insertion sorted, once more
+     *        than 1 in this many of its entries are out of order
+     */
+    const size_t RENDER_SORT_DISORDER = 16;
+
     /** \brief A collection of GenEx objects.
      */
     class Layer : public Object {
     protected:
-        std::unordered_map<Uint64, std::shared_ptr<Object> > objects; // maps IDs to objects
+        typedef std::pair<Uint64, std::shared_ptr<Object> > Entry;
+
+        Util::SlotMap<Entry> objects; // children packed together; (ID, object)
+        std::unordered_map<Uint64, Util::SlotHandle> handles; // maps IDs to slots in objects
         std::unordered_map<std::string, Uint64> id_map; // maps strings to IDs
+        std::unordered_map<Uint64, std::string> name_map; // maps IDs to strings
+        std::unordered_map<std::string, Uint64> name_counters; // name prefix -> next free suffix
+
+        bool has_dead = false; // a traversal skipped a dead child that hasn't been swept yet
+
+        struct RenderEntry {
+            Util::SlotHandle handle;
+            double z;
+            Sint32 sort_key;
+            Uint64 id;
+
+            bool operator< (const RenderEntry &other) const {
+                if (z != other.z)
+                    return z < other.z;
+                if (sort_key != other.sort_key)
+                    return sort_key < other.sort_key;
+                return id < other.id;
+            }
+        };
+
+        // moves every child in one pass per update; see set_bulk_transforms()
+        std::unique_ptr<TransformStore> transforms;
+
+        // children in draw order, back to front; kept nearly sorted between frames
+        std::vector<RenderEntry> render_list;
+
+        /** \brief Drops removed children from the render list, refreshes every entry's depth &
+         *        sort key and re-sorts it. Insertion sort, so a list that barely changed since
+         *        the last frame costs O(n); a stable sort once many entries moved or were added.
+         */
+        void sort_render_list();
+
+        /** \brief Stores a child & indexes it by ID and by name. A child already stored under
+         *        the same ID is replaced along with its name.
+         *
+         * \param std::shared_ptr(Object) <u>objptr</u>: The child to store
+         * \param std::string <u>name</u>: The child's string identifier; must not be taken
+         *
+         */
+        void insert_object(std::shared_ptr<Object> objptr, std::string name);
+
+        /** \brief Drops a child from storage & every index.
+         *
+         * \param Uint64 <u>num_id</u>: The numeric ID of the child
+         * \return bool FALSE if no child with that ID was stored
+         *
+         */
+        bool erase_object(Uint64 num_id);
+
+        /** \brief Returns whether the child at a position in storage is still stored, rather
+         *        than waiting for the current traversal to end to be erased.
+         *
+         * \param size_t <u>index</u>: Position in storage
+         * \return bool TRUE if the child hasn't been removed
+         *
+         */
+        bool is_stored(size_t index);
+
+        // traversals walk children by position through plain pointers; children erased while
+        // one is running keep their slot, so no one is skipped or moved, until the outermost
+        // one ends. Children dropped by destroy() mid-walk are parked in the graveyard.
+        int traversals = 0;
+        std::vector<Util::SlotHandle> pending_erase;
+        std::vector< std::shared_ptr<Object> > graveyard;
+
+        /** \brief Marks a traversal of a layer's children for as long as it's in scope. The
+         *        outermost one erases the children removed meanwhile when it ends.
+         */
+        class TraversalGuard {
+        private:
+            Layer *layer;
+
+        public:
+            TraversalGuard(Layer *layer);
+            ~TraversalGuard();
+        };
+
+        bool parallel = false; // update children on the job pool instead of in order
+        size_t parallel_grain = DEFAULT_PARALLEL_GRAIN; // children per job
+
+        Events::EventMask subtree_mask = Events::MASK_NONE; // own mask | every child's mask
+        std::atomic<bool> subtree_dirty{true}; // subtree_mask needs computing again; if set,
+                                                // it's set in every layer above this one too
+
+        friend class Object; // children mark their parents dirty
+        void mark_subtree_dirty();
+        void adopt(Object *child);
+        void disown(Object *child);
+
+        struct HitSpan {
+            long x0, y0, x1, y1; // grid cells covered, inclusive
+            bool always; // filed in hit_always instead of in cells
+        };
+
+        // uniform grid of bounded children; rebuilt lazily after child changes & patched lazily
+        // after updates, refiling only the children that crossed into other cells
+        std::unordered_map<Uint64, std::vector<Object*> > hit_cells;
+        std::unordered_map<Object*, HitSpan> hit_spans; // where each child was last filed
+        std::vector<Object*> hit_always; // unbounded or very large children
+        std::vector<Object*> hit_scratch; // candidates of the last pointer event; reused
+        double hit_cell_size = DEFAULT_HIT_CELL_SIZE;
+        bool hit_dirty = true; // children were added or removed
+        bool hit_moved = true; // children may have moved since they were last filed
+
+        static thread_local int render_depth; // how many layers up the current render call is
+
+        /** \brief Works out which grid cells a child covers right now.
+         *
+         * \param Object *<u>child</u>: The child to look at
+         * \return HitSpan The cells under the child's bounds
+         *
+         */
+        HitSpan get_hit_span(Object *child);
+
+        /** \brief Rebuilds the hit-testing grid from the children's current bounds.
+         */
+        void build_hit_grid();
+
+        /** \brief Brings the hit-testing grid up to date: rebuilds it after children were added
+         *        or removed, or refiles the children that moved into other cells.
+         */
+        void refresh_hit_grid();
+
+        /** \brief Sends a pointer event to the children under a point, front to back, stopping
+         *        after the first opaque one; then to every unbounded child.
+         *
+         * Children's bounds are placed with the translation of this layer's world transform as
+         * of the last render, the same offset their render() got.
+         *
+         * \param double <u>x</u>: X-position of the pointer in window coordinates
+         * \param double <u>y</u>: Y-position of the pointer in window coordinates
+         * \param Events::EventMask <u>kind</u>: The event kind being sent
+         * \param std::function <u>fn</u>: Hands the event to one child
+         * \return bool FALSE if <u>fn</u> returned FALSE for any child
+         *
+         */
+        bool dispatch_pointer(double x, double y, Events::EventMask kind,
+                              const std::function<bool(Object*)> &fn);
+
+        /** \brief Runs <u>fn</u> on every live child across the job pool; dead children are
+         *        left for the caller to sweep.
+         *
+         * \param std::function <u>fn</u>: Called once per live child
+         * \return bool FALSE if <u>fn</u> returned FALSE for any child
+         *
+         */
+        bool run_parallel(const std::function<bool(Object*)> &fn);
 
     public:
 // ------ LAYER CONSTRUCTORS ----------------------------------------------------------------------
@@ -557,6 +1050,10 @@ namespace GenEx {
          */
         Layer(std::initializer_list<Object*> init_list);
 
+        /** \brief Detaches the children, which may live on if they're shared elsewhere.
+         */
+        ~Layer();
+
 // ------ LAYER OPERATORS -------------------------------------------------------------------------
 
         /** \brief Copy assignment for GenEx Layers.
@@ -593,6 +1090,68 @@ namespace GenEx {
          */
         size_t num_objects();
 
+        /** \brief Sets whether this layer updates its children in order or spreads them across
+         *        the job pool. Layers are ordered by default; only make a layer parallel if none
+         *        of its children touch each other's state in update() or targetreset(), and
+         *        none of them call into SDL_Renderer from there (it isn't thread-safe).
+         *
+         * \param bool <u>parallel</u>: TRUE to update children on the job pool
+         * \param size_t <u><i>grain</i></u>: How many children each job updates; defaults to
+         *        <i>DEFAULT_PARALLEL_GRAIN</i>
+         *
+         */
+        void set_parallel(bool parallel, size_t grain = DEFAULT_PARALLEL_GRAIN);
+
+        /** \brief Returns whether this layer updates its children on the job pool.
+         *
+         * \return bool TRUE if the layer is parallel
+         *
+         */
+        bool is_parallel();
+
+        /** \brief Sets whether this layer moves its children in bulk. When on, every child's
+         *        transform lives in a TransformStore that is integrated in one SIMD pass at the
+         *        start of update(); children then skip their own integration, & children whose
+         *        get_event_mask() lacks <i>MASK_UPDATE</i> aren't sent update() at all. Each
+         *        child is still visited to copy its results back, so this is slower than plain
+         *        updates unless something else reads the store (see TransformStore).
+         *        Subclasses that never subscribe() are always sent it. Children that are
+         *        already in another store keep using it. Copies of a layer start with this
+         *        off; moves keep it.
+         *
+         * \param bool <u>bulk</u>: TRUE to integrate children in bulk
+         *
+         */
+        void set_bulk_transforms(bool bulk);
+
+        /** \brief Returns whether this layer moves its children in bulk.
+         *
+         * \return bool TRUE if the children's transforms are in a TransformStore
+         *
+         */
+        bool has_bulk_transforms();
+
+        /** \brief Gets the event kinds this layer or any object inside it handles. Cached until
+         *        something inside it subscribes to a new event kind or changes children.
+         *
+         * \return Events::EventMask Bits set for every handled event kind
+         *
+         */
+        Events::EventMask get_event_mask() override;
+
+        /** \brief Sets the cell size of this layer's hit-testing grid. Roughly the size of a
+         *        typical child works best.
+         *
+         * \param double <u>size</u>: Cell width & height
+         *
+         */
+        void set_hit_cell_size(double size);
+
+        /** \brief Makes this layer check its children's cells before the next pointer event.
+         *        Only needed after moving or resizing children outside of update().
+         */
+        void invalidate_hit_grid();
+
         /** \brief Adds a new object to this layer.
          *
          * \param std::shared_ptr(Object) *<u>objptr</u>: Shared pointer to an object to add
@@ -602,6 +1161,15 @@ namespace GenEx {
          */
         std::string add_object(std::shared_ptr<Object> objptr, std::string name);
 
+        /** \brief Gets the string identifier of an object in this layer.
+         *
+         * \param Uint64 <u>num_id</u>: The numeric ID of the object
+         * \return std::string The object's string identifier, or an empty string if no object
+         *         with the provided ID is found in this layer
+         *
+         */
+        std::string get_name(Uint64 num_id);
+
         /** \brief Adds a new object to this layer.
          *
          * \param Object *<u>objptr</u>: Raw pointer to an object to add
@@ -633,19 +1201,20 @@ namespace GenEx {
 
         /** \brief Returns the begin iterator for iterating over objects.
          *
-         * \return std::unordered_map::const_iterator Read-only iterator to the beginning of the
-         *         object collection in this layer.
+         * \return Util::SlotMap::const_iterator Read-only iterator to the beginning of the
+         *         object collection in this layer; each element is an (ID, object) pair.
+         *         Children removed during a traversal are still included until it ends.
          *
          */
-        std::unordered_map<Uint64, std::shared_ptr<Object> >::const_iterator begin() const;
+        Util::SlotMap<Entry>::const_iterator begin() const;
 
         /** \brief Returns the end iterator for iterating over objects.
          *
-         * \return std::unordered_map::const_iterator Read-only iterator to the end of the
+         * \return Util::SlotMap::const_iterator Read-only iterator to the end of the
          *         object collection in this layer.
          *
          */
-        std::unordered_map<Uint64, std::shared_ptr<Object> >::const_iterator end() const;
+        Util::SlotMap<Entry>::const_iterator end() const;
 
         /** \brief Gets an object from this layer.
          *
@@ -689,6 +1258,33 @@ namespace GenEx {
          */
         void remove_object(std::shared_ptr<Object> &objptr);
 
+        /** \brief Removes many objects from this layer at once; IDs that don't match an object
+         *        in this layer are skipped. Not safe to call while this layer is walking its
+         *        children; use destroy_objects() from inside event handlers.
+         *
+         * \param std::vector<Uint64> &<u>num_ids</u>: The numeric IDs of the objects
+         * \return size_t How many objects were removed
+         *
+         */
+        size_t remove_objects(const std::vector<Uint64> &num_ids);
+
+        /** \brief Destroys many objects in this layer at once. They stay in place, skipped by
+         *        every traversal, until the end of this layer's next update() sweeps them out in
+         *        one batch. Safe to call at any point in the frame.
+         *
+         * \param std::vector<Uint64> &<u>num_ids</u>: The numeric IDs of the objects
+         *
+         */
+        void destroy_objects(const std::vector<Uint64> &num_ids);
+
+        /** \brief Removes every dead object from this layer now instead of at the next
+         *        update().
+         *
+         * \return size_t How many objects were removed
+         *
+         */
+        size_t remove_dead();
+
 // ------ LAYER EVENT HANDLERS --------------------------------------------------------------------
 
         virtual void render(SDL_Renderer *target, int offset_x, int offset_y, int offset_z);
@@ -0,0 +1,244 @@
+/**
+ * \file record.cpp
+ *
+ * \author Simon Struthers <snstruthers@gmail.com>
+ * \version pre_dev v0.1.0
+ *
+ * \section LICENSE
+ * GenEx (short for General Executor) - window manager and runtime environment.
+ * Copyright (C) 2019 | The GenEx Project
+ *
+ * This file is part of GenEx.
+ *
+ * GenEx is free software: you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License version 2 as published by the Free Software Foundation.
+ *
+ * GenEx is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at https://www.gnu.org/copyleft/gpl.html
+ *
+ * You should have received a copy of the GNU General Public License version 2 along with GenEx.
+ * If not, see http://www.gnu.org/licenses.
+ *
+ * \section DESCRIPTION
+ * The source file for recording polled events to a log & replaying them.
+ *
+ */
+
+#include "record.hpp"
+
+// --- WINDOW DATA SERIALIZATION ------------------------------------------------------------------
+
+namespace {
+    template <typename T>
+    void PutValue(std::string &out, const T &value) {
+        out.append((const char*)&value, sizeof(T));
+    }
+
+    void PutString(std::string &out, const std::string &str) {
+        PutValue(out, (Uint32)str.size());
+        out.append(str);
+    }
+
+    template <typename T>
+    bool GetValue(const std::string &in, size_t &pos, T &value) {
+        if (pos + sizeof(T) > in.size())
+            return false;
+        SDL_memcpy(&value, in.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    bool GetString(const std::string &in, size_t &pos, std::string &str) {
+        Uint32 size;
+        if (!GetValue(in, pos, size) || pos + size > in.size())
+            return false;
+        str.assign(in, pos, size);
+        pos += size;
+        return true;
+    }
+
+    void PutWindowData(std::string &out, const GenEx::Graphics::WindowData &windt) {
+        PutString(out, windt.title);
+        PutValue(out, windt.x);
+        PutValue(out, windt.y);
+        PutValue(out, windt.w);
+        PutValue(out, windt.h);
+        PutValue(out, windt.winflags);
+        PutValue(out, windt.renflags);
+        PutValue(out, windt.framerate);
+        PutValue(out, windt.tickrate);
+        PutValue(out, (Uint8)windt.headless);
+        PutString(out, windt.frame_dump);
+        PutValue(out, windt.max_frames);
+        PutValue(out, (Uint8)windt.backend);
+    }
+
+    bool GetWindowData(const std::string &in, GenEx::Graphics::WindowData &windt) {
+        size_t pos = 0;
+        Uint8 headless = 0, backend = 0;
+        bool ok = GetString(in, pos, windt.title) && GetValue(in, pos, windt.x) &&
+                  GetValue(in, pos, windt.y) && GetValue(in, pos, windt.w) &&
+                  GetValue(in, pos, windt.h) && GetValue(in, pos, windt.winflags) &&
+                  GetValue(in, pos, windt.renflags) && GetValue(in, pos, windt.framerate) &&
+                  GetValue(in, pos, windt.tickrate) && GetValue(in, pos, headless) &&
+                  GetString(in, pos, windt.frame_dump) && GetValue(in, pos, windt.max_frames) &&
+                  GetValue(in, pos, backend);
+        windt.headless = headless != 0;
+        windt.backend = (GenEx::Graphics::RenderBackend)backend;
+        return ok;
+    }
+
+    bool IsUserEvent(Uint32 type) { return type >= SDL_USEREVENT && type < SDL_LASTEVENT; }
+}
+
+// --- EVENT RECORDER -----------------------------------------------------------------------------
+
+GenEx::Replay::Recorder::Recorder(std::string path) {
+    t_start = GenEx::Time::GetTime();
+
+    file = gzopen(path.c_str(), "wb");
+    if (file != nullptr) {
+        Uint32 header[3] = { GenEx::Replay::LOG_MAGIC, GenEx::Replay::LOG_VERSION,
+                             (Uint32)sizeof(SDL_Event) };
+        gzwrite(file, header, sizeof(header));
+    }
+}
+
+GenEx::Replay::Recorder::~Recorder() {
+    if (file != nullptr)
+        gzclose(file);
+}
+
+bool GenEx::Replay::Recorder::is_open() { return file != nullptr; }
+
+void GenEx::Replay::Recorder::add_window(Uint32 window_id) {
+    num_windows++;
+    if (window_id != 0)
+        ordinals[window_id] = num_windows;
+}
+
+void GenEx::Replay::Recorder::record(const SDL_Event &event) {
+    if (file == nullptr || event.type == SDL_SYSWMEVENT)
+        return;
+
+    double time = GenEx::Time::GetTime() - t_start;
+    SDL_Event copy = event;
+    extra.clear();
+
+    Uint32 window_id = GenEx::Graphics::EventRouter::GetEventWindowID(event);
+    if (window_id != 0) {
+        auto ordinal = ordinals.find(window_id);
+        GenEx::Graphics::EventRouter::SetEventWindowID(copy, ordinal != ordinals.end() ?
+                                                             ordinal->second : 0);
+    }
+
+    if (event.type == SDL_DROPFILE || event.type == SDL_DROPTEXT) {
+        if (event.drop.file != nullptr)
+            extra = event.drop.file;
+        copy.drop.file = nullptr;
+    }
+    else if (event.type == GENEX_CREATEWINDOWEVENT) {
+        PutWindowData(extra, *(GenEx::Graphics::WindowData*)event.user.data1);
+        copy.user.data1 = nullptr;
+        copy.user.data2 = nullptr;
+    }
+    else if (IsUserEvent(event.type)) {
+        copy.user.data1 = nullptr;
+        copy.user.data2 = nullptr;
+    }
+
+    Uint32 extra_size = extra.size();
+    gzwrite(file, &time, sizeof(time));
+    gzwrite(file, &copy, sizeof(copy));
+    gzwrite(file, &extra_size, sizeof(extra_size));
+    if (extra_size > 0)
+        gzwrite(file, extra.data(), extra_size);
+}
+
+// --- EVENT PLAYER -------------------------------------------------------------------------------
+
+GenEx::Replay::Player::Player(std::string path, bool max_speed) : max_speed(max_speed) {
+    t_start = GenEx::Time::GetTime();
+
+    file = gzopen(path.c_str(), "rb");
+    if (file == nullptr)
+        return;
+
+    Uint32 header[3];
+    if (gzread(file, header, sizeof(header)) != (int)sizeof(header) ||
+            header[0] != GenEx::Replay::LOG_MAGIC || header[1] != GenEx::Replay::LOG_VERSION ||
+            header[2] != sizeof(SDL_Event)) {
+        SDL_Log("Replay: %s is not a compatible event log\n", path.c_str());
+        gzclose(file);
+        file = nullptr;
+        return;
+    }
+
+    read_next();
+}
+
+GenEx::Replay::Player::~Player() {
+    if (file != nullptr)
+        gzclose(file);
+}
+
+bool GenEx::Replay::Player::is_open() { return file != nullptr; }
+
+bool GenEx::Replay::Player::finished() { return !has_next; }
+
+bool GenEx::Replay::Player::read_next() {
+    Uint32 extra_size = 0;
+    has_next = file != nullptr &&
+               gzread(file, &next_time, sizeof(next_time)) == (int)sizeof(next_time) &&
+               gzread(file, &next_event, sizeof(next_event)) == (int)sizeof(next_event) &&
+               gzread(file, &extra_size, sizeof(extra_size)) == (int)sizeof(extra_size);
+
+    if (has_next) {
+        next_extra.resize(extra_size);
+        if (extra_size > 0 && gzread(file, &next_extra[0], extra_size) != (int)extra_size)
+            has_next = false;
+    }
+    return has_next;
+}
+
+void GenEx::Replay::Player::add_window(Uint32 window_id) { window_ids.push_back(window_id); }
+
+double GenEx::Replay::Player::next_deadline() {
+    if (!has_next)
+        return std::numeric_limits<double>::infinity();
+    return t_start + next_time - skipped;
+}
+
+void GenEx::Replay::Player::begin_poll(double now) {
+    if (max_speed && has_next && next_deadline() > now)
+        skipped += next_deadline() - now;
+}
+
+bool GenEx::Replay::Player::poll(SDL_Event &event, double now) {
+    if (!has_next || next_deadline() > now)
+        return false;
+
+    event = next_event;
+
+    // map creation order back on to this session's window IDs
+    Uint32 ordinal = GenEx::Graphics::EventRouter::GetEventWindowID(event);
+    if (ordinal != 0)
+        GenEx::Graphics::EventRouter::SetEventWindowID(event, ordinal <= window_ids.size() ?
+                                                              window_ids[ordinal - 1] : 0);
+
+    if (event.type == SDL_DROPFILE || event.type == SDL_DROPTEXT) {
+        if (!next_extra.empty())
+            event.drop.file = SDL_strdup(next_extra.c_str());
+    }
+    else if (event.type == GENEX_CREATEWINDOWEVENT) {
+        // event handlers are code and can't be logged; replayed windows use the defaults
+        GenEx::Graphics::WindowData *windt = new GenEx::Graphics::WindowData();
+        GetWindowData(next_extra, *windt);
+        event.user.data1 = (void*)windt;
+        event.user.data2 = (void*)GenEx::Events::GetDefaultHandlerTable();
+    }
+
+    read_next();
+    return true;
+}
@@ -0,0 +1,195 @@
+/**
+ * \file record.hpp
+ *
+ * \author Simon Struthers <snstruthers@gmail.com>
+ * \version pre_dev v0.1.0
+ *
+ * \section LICENSE
+ * GenEx (short for General Executor) - window manager and runtime environment.
+ * Copyright (C) 2019 | The GenEx Project
+ *
+ * This file is part of GenEx.
+ *
+ * GenEx is free software: you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License version 2 as published by the Free Software Foundation.
+ *
+ * GenEx is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at https://www.gnu.org/copyleft/gpl.html
+ *
+ * You should have received a copy of the GNU General Public License version 2 along with GenEx.
+ * If not, see http://www.gnu.org/licenses.
+ *
+ * \section DESCRIPTION
+ * The header file for recording polled events to a log & replaying them.
+ *
+ */
+
+#ifndef RECORD_HPP
+#define RECORD_HPP
+
+#include "base.hpp"
+#include "time.hpp"
+#include "graphics/window.hpp"
+#include "zlib.h"
+
+namespace GenEx {
+    namespace Replay {
+
+// --- EVENT LOG FORMAT ---------------------------------------------------------------------------
+
+        /** \brief Identifies a GenEx event log ("GXEV")
+         */
+        const Uint32 LOG_MAGIC = 0x56455847;
+
+        /** \brief The event log format version
+         */
+        const Uint32 LOG_VERSION = 2;
+
+        /* A log is a gzip stream of native-endian values:
+         *   header: Uint32 magic, Uint32 version, Uint32 sizeof(SDL_Event)
+         *   record: double time, SDL_Event event, Uint32 extra_size, extra_size bytes of extra
+         *
+         * Window IDs are stored as the order the windows were created in (1 for the first) so
+         * they can be mapped on to whichever IDs the replaying session hands out. Pointers are
+         * stored as NULL; the data behind dropped files & created windows goes in <extra>.
+         */
+
+// --- EVENT RECORDER -----------------------------------------------------------------------------
+
+        /** \brief Writes polled events to a compressed event log.
+         */
+        class Recorder {
+        private:
+            gzFile file;
+            double t_start;
+
+            std::unordered_map<Uint32, Uint32> ordinals; // window ID -> creation order
+            Uint32 num_windows = 0;
+
+            std::string extra; // scratch buffer for a record's extra data
+
+        public:
+            /** \brief Opens a new event log, replacing any existing file.
+             *
+             * \param std::string <u>path</u>: Where to write the log
+             *
+             */
+            Recorder(std::string path);
+
+            Recorder(const Recorder &other) = delete;
+            Recorder &operator= (const Recorder &other) = delete;
+
+            /** \brief Flushes & closes the log.
+             */
+            ~Recorder();
+
+            /** \brief Returns whether or not the log could be opened.
+             *
+             * \return bool TRUE if events are being recorded
+             *
+             */
+            bool is_open();
+
+            /** \brief Tells the recorder a window was created; must be called in creation order.
+             *
+             * \param Uint32 <u>window_id</u>: The ID from Window::get_window_id()
+             *
+             */
+            void add_window(Uint32 window_id);
+
+            /** \brief Appends a polled event to the log. System window manager events are
+             *        skipped since they can't be replayed.
+             *
+             * \param SDL_Event &<u>event</u>: The event to record
+             *
+             */
+            void record(const SDL_Event &event);
+        };
+
+// --- EVENT PLAYER -------------------------------------------------------------------------------
+
+        /** \brief Reads events back from an event log when they come due.
+         */
+        class Player {
+        private:
+            gzFile file;
+            double t_start;
+            double skipped = 0.0; // idle time jumped over when playing at maximum speed
+            bool max_speed;
+
+            bool has_next = false;
+            double next_time;
+            SDL_Event next_event;
+            std::string next_extra;
+
+            std::vector<Uint32> window_ids; // creation order - 1 -> window ID
+
+            bool read_next();
+
+        public:
+            /** \brief Opens an event log for playback. The log's clock starts now.
+             *
+             * \param std::string <u>path</u>: The log to read
+             * \param bool <u><i>max_speed</i></u>: TRUE to skip the idle time between events
+             *        instead of waiting it out; defaults to FALSE
+             *
+             */
+            Player(std::string path, bool max_speed = false);
+
+            Player(const Player &other) = delete;
+            Player &operator= (const Player &other) = delete;
+
+            ~Player();
+
+            /** \brief Returns whether or not the log could be opened & is a valid event log.
+             *
+             * \return bool TRUE if the log can be played
+             *
+             */
+            bool is_open();
+
+            /** \brief Returns whether or not every event in the log has been played.
+             *
+             * \return bool TRUE if the log is used up
+             *
+             */
+            bool finished();
+
+            /** \brief Tells the player a window was created; must be called in creation order.
+             *
+             * \param Uint32 <u>window_id</u>: The ID from Window::get_window_id()
+             *
+             */
+            void add_window(Uint32 window_id);
+
+            /** \brief Gets when the next event comes due.
+             *
+             * \return double The time (see <i>Time::GetTime()</i>) of the next event, or
+             *         infinity if the log is used up
+             *
+             */
+            double next_deadline();
+
+            /** \brief Starts a new polling pass. At maximum speed, jumps the log's clock ahead
+             *        to the next event if none are due yet, so one batch is played per pass.
+             *
+             * \param double <u>now</u>: The current time; see <i>Time::GetTime()</i>
+             *
+             */
+            void begin_poll(double now);
+
+            /** \brief Takes the next due event out of the log. Window IDs are mapped on to this
+             *        session's windows; windows that don't exist (or are headless) map to 0.
+             *
+             * \param SDL_Event &<u>event</u>: Where to store the event
+             * \param double <u>now</u>: The current time; see <i>Time::GetTime()</i>
+             * \return bool FALSE if no event is due yet
+             *
+             */
+            bool poll(SDL_Event &event, double now);
+        };
+    }
+}
+
+#endif // RECORD_HPP
@@ -0,0 +1,299 @@
+/**
+ * \file staticobject.hpp
+ *
+ * \author Simon Struthers <snstruthers@gmail.com>
+ * \version pre_dev v0.1.0
+ *
+ * \section LICENSE
+ * GenEx (short for General Executor) - window manager and runtime environment.
+ * Copyright (C) 2019 | The GenEx Project
+ *
+ * This file is part of GenEx.
+ *
+ * GenEx is free software: you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License version 2 as published by the Free Software Foundation.
+ *
+ * GenEx is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at https://www.gnu.org/copyleft/gpl.html
+ *
+ * You should have received a copy of the GNU General Public License version 2 along with GenEx.
+ * If not, see http://www.gnu.org/licenses.
+ *
+ * \section DESCRIPTION
+ * The header file for objects whose event handlers are bound at compile time.
+ *
+ */
+
+#ifndef STATICOBJECT_HPP
+#define STATICOBJECT_HPP
+
+#include <type_traits>
+
+#include "base.hpp"
+#include "math.hpp"
+#include "events.hpp"
+#include "object.hpp"
+
+namespace GenEx {
+
+// --- STATIC OBJECT CLASS ------------------------------------------------------------------------
+
+    // MASK_NONE if Derived left <hook> alone, <bit> if it defined its own
+    #define GENEX_HOOK_MASK(hook, bit) \
+        (std::is_same<decltype(&Derived::hook), decltype(&StaticObject::hook)>::value ? \
+         Events::MASK_NONE : Events::bit)
+
+    /** \brief Base for object types whose event handlers are known at compile time.
+     *
+     * Derive as <i>class Ball : public StaticObject<Ball></i> and define any of the on_*()
+     * hooks below with the same signature, e.g. <i>bool on_keydown(SDL_Keycode key,
+     * SDL_Scancode scancode, Uint16 mod, Uint8 repeat)</i>. Each event virtual calls the hook
+     * directly instead of going through an EventHandlers table, so it can be inlined, and the
+     * event mask is worked out from which hooks Derived defines, so Layers never call the
+     * ones it leaves alone. The object's handler table stays the default one; set_event_handler()
+     * has no effect on the events StaticObject dispatches itself.
+     *
+     * Use Derived's constructor & destructor in place of init & destroy handlers.
+     *
+     * \param typename <u>Derived</u>: The class deriving from this one
+     *
+     */
+    template <typename Derived>
+    class StaticObject : public Object {
+    private:
+        Derived *derived() { return static_cast<Derived*>(this); }
+
+    public:
+        /** \brief Gets the event kinds Derived defines hooks for.
+         *
+         * \return Events::EventMask Bits set for every hook Derived defines
+         *
+         */
+        static constexpr Events::EventMask StaticEventMask() {
+            return GENEX_HOOK_MASK(on_update, MASK_UPDATE) |
+                   GENEX_HOOK_MASK(on_targetreset, MASK_TARGETRESET) |
+                   GENEX_HOOK_MASK(on_windowevent, MASK_WINDOWEVENT) |
+                   GENEX_HOOK_MASK(on_keydown, MASK_KEYDOWN) |
+                   GENEX_HOOK_MASK(on_keyup, MASK_KEYUP) |
+                   GENEX_HOOK_MASK(on_textediting, MASK_TEXTEDITING) |
+                   GENEX_HOOK_MASK(on_textinput, MASK_TEXTINPUT) |
+                   GENEX_HOOK_MASK(on_mousedown, MASK_MOUSEDOWN) |
+                   GENEX_HOOK_MASK(on_mouseup, MASK_MOUSEUP) |
+                   GENEX_HOOK_MASK(on_mousemotion, MASK_MOUSEMOTION) |
+                   GENEX_HOOK_MASK(on_mousewheel, MASK_MOUSEWHEEL) |
+                   GENEX_HOOK_MASK(on_clipboardupdate, MASK_CLIPBOARDUPDATE) |
+                   GENEX_HOOK_MASK(on_filedrop, MASK_FILEDROP) |
+                   GENEX_HOOK_MASK(on_textdrop, MASK_TEXTDROP) |
+                   GENEX_HOOK_MASK(on_begindrop, MASK_BEGINDROP) |
+                   GENEX_HOOK_MASK(on_completedrop, MASK_COMPLETEDROP) |
+                   GENEX_HOOK_MASK(on_jaxis, MASK_JAXIS) |
+                   GENEX_HOOK_MASK(on_jball, MASK_JBALL) |
+                   GENEX_HOOK_MASK(on_jhat, MASK_JHAT) |
+                   GENEX_HOOK_MASK(on_jbtndown, MASK_JBTNDOWN) |
+                   GENEX_HOOK_MASK(on_jbtnup, MASK_JBTNUP) |
+                   GENEX_HOOK_MASK(on_caxis, MASK_CAXIS) |
+                   GENEX_HOOK_MASK(on_cbtndown, MASK_CBTNDOWN) |
+                   GENEX_HOOK_MASK(on_cbtnup, MASK_CBTNUP) |
+                   GENEX_HOOK_MASK(on_fingerdown, MASK_FINGERDOWN) |
+                   GENEX_HOOK_MASK(on_fingerup, MASK_FINGERUP) |
+                   GENEX_HOOK_MASK(on_fingermotion, MASK_FINGERMOTION) |
+                   GENEX_HOOK_MASK(on_gesturerecord, MASK_GESTURERECORD) |
+                   GENEX_HOOK_MASK(on_gestureperform, MASK_GESTUREPERFORM) |
+                   GENEX_HOOK_MASK(on_multigesture, MASK_MULTIGESTURE) |
+                   GENEX_HOOK_MASK(on_userevent, MASK_USEREVENT);
+        }
+
+        StaticObject() : Object() { subscribe(StaticEventMask()); }
+
+// ------ DEFAULT HOOKS ---------------------------------------------------------------------------
+
+        void on_render(SDL_Renderer *target, int offset_x, int offset_y, int offset_z) { }
+        bool on_update(double elapsed) { return true; }
+        bool on_targetreset() { return true; }
+        bool on_windowevent(Uint8 event, Sint32 data1, Sint32 data2) { return true; }
+        bool on_keydown(SDL_Keycode key, SDL_Scancode scancode, Uint16 mod,
+                        Uint8 repeat) { return true; }
+        bool on_keyup(SDL_Keycode key, SDL_Scancode scancode, Uint16 mod,
+                      Uint8 repeat) { return true; }
+        bool on_textediting(char text[SDL_TEXTEDITINGEVENT_TEXT_SIZE], Sint32 start,
+                            Sint32 length) { return true; }
+        bool on_textinput(char text[SDL_TEXTINPUTEVENT_TEXT_SIZE]) { return true; }
+        bool on_mousedown(Sint32 x, Sint32 y, Uint8 button, Uint8 clicks,
+                          Uint32 which) { return true; }
+        bool on_mouseup(Sint32 x, Sint32 y, Uint8 button, Uint8 clicks,
+                        Uint32 which) { return true; }
+        bool on_mousemotion(Sint32 x, Sint32 y, Sint32 xrel, Sint32 yrel, bool buttons[5],
+                            Uint32 which) { return true; }
+        bool on_mousewheel(bool flipped, Sint32 x, Sint32 y, Uint32 which) { return true; }
+        bool on_clipboardupdate(char text[]) { return true; }
+        bool on_filedrop(std::string filename) { return true; }
+        bool on_textdrop(char text[]) { return true; }
+        bool on_begindrop() { return true; }
+        bool on_completedrop() { return true; }
+        bool on_jaxis(SDL_JoystickID joystick_id, Uint8 axis, Sint16 value) { return true; }
+        bool on_jball(SDL_JoystickID joystick_id, Uint8 ball, Sint16 x, Sint16 y) { return true; }
+        bool on_jhat(SDL_JoystickID joystick_id, Uint8 hat, Uint8 value) { return true; }
+        bool on_jbtndown(SDL_JoystickID joystick_id, Uint8 button) { return true; }
+        bool on_jbtnup(SDL_JoystickID joystick_id, Uint8 button) { return true; }
+        bool on_caxis(SDL_JoystickID controller_id, Uint8 axis, Sint16 value) { return true; }
+        bool on_cbtndown(SDL_JoystickID controller_id, Uint8 button) { return true; }
+        bool on_cbtnup(SDL_JoystickID controller_id, Uint8 button) { return true; }
+        bool on_fingerdown(SDL_TouchID touch_id, SDL_FingerID finger_id, float x, float y,
+                           float pressure) { return true; }
+        bool on_fingerup(SDL_TouchID touch_id, SDL_FingerID finger_id, float x, float y,
+                         float pressure) { return true; }
+        bool on_fingermotion(SDL_TouchID touch_id, SDL_FingerID finger_id, float x, float y,
+                             float dx, float dy, float pressure) { return true; }
+        bool on_gesturerecord(SDL_TouchID touch_id, SDL_GestureID gesture_id, Uint32 num_fingers,
+                              float x, float y) { return true; }
+        bool on_gestureperform(SDL_TouchID touch_id, SDL_GestureID gesture_id, Uint32 num_fingers,
+                               float x, float y, float error) { return true; }
+        bool on_multigesture(SDL_TouchID touch_id, Uint16 num_fingers, float x, float y,
+                             float d_theta, float d_dist) { return true; }
+        bool on_userevent(Sint32 code, void *data1, void *data2) { return true; }
+
+// ------ DISPATCH --------------------------------------------------------------------------------
+
+        void render(SDL_Renderer *target, int offset_x, int offset_y, int offset_z) override {
+            derived()->on_render(target, offset_x, offset_y, offset_z);
+        }
+
+        bool update(double elapsed) override {
+            integrate(elapsed);
+            return derived()->on_update(elapsed);
+        }
+
+        bool targetreset() override {
+            return derived()->on_targetreset();
+        }
+
+        bool windowevent(Uint8 event, Sint32 data1, Sint32 data2) override {
+            return derived()->on_windowevent(event, data1, data2);
+        }
+
+        bool keydown(SDL_Keycode key, SDL_Scancode scancode, Uint16 mod, Uint8 repeat) override {
+            return derived()->on_keydown(key, scancode, mod, repeat);
+        }
+
+        bool keyup(SDL_Keycode key, SDL_Scancode scancode, Uint16 mod, Uint8 repeat) override {
+            return derived()->on_keyup(key, scancode, mod, repeat);
+        }
+
+        bool textediting(char text[SDL_TEXTEDITINGEVENT_TEXT_SIZE], Sint32 start,
+                         Sint32 length) override {
+            return derived()->on_textediting(text, start, length);
+        }
+
+        bool textinput(char text[SDL_TEXTINPUTEVENT_TEXT_SIZE]) override {
+            return derived()->on_textinput(text);
+        }
+
+        bool mousedown(Sint32 x, Sint32 y, Uint8 button, Uint8 clicks, Uint32 which) override {
+            return derived()->on_mousedown(x, y, button, clicks, which);
+        }
+
+        bool mouseup(Sint32 x, Sint32 y, Uint8 button, Uint8 clicks, Uint32 which) override {
+            return derived()->on_mouseup(x, y, button, clicks, which);
+        }
+
+        bool mousemotion(Sint32 x, Sint32 y, Sint32 xrel, Sint32 yrel, bool buttons[5],
+                         Uint32 which) override {
+            return derived()->on_mousemotion(x, y, xrel, yrel, buttons, which);
+        }
+
+        bool mousewheel(bool flipped, Sint32 x, Sint32 y, Uint32 which) override {
+            return derived()->on_mousewheel(flipped, x, y, which);
+        }
+
+        bool clipboardupdate(char text[]) override {
+            return derived()->on_clipboardupdate(text);
+        }
+
+        bool filedrop(std::string filename) override {
+            return derived()->on_filedrop(filename);
+        }
+
+        bool textdrop(char text[]) override {
+            return derived()->on_textdrop(text);
+        }
+
+        bool begindrop() override {
+            return derived()->on_begindrop();
+        }
+
+        bool completedrop() override {
+            return derived()->on_completedrop();
+        }
+
+        bool jaxis(SDL_JoystickID joystick_id, Uint8 axis, Sint16 value) override {
+            return derived()->on_jaxis(joystick_id, axis, value);
+        }
+
+        bool jball(SDL_JoystickID joystick_id, Uint8 ball, Sint16 x, Sint16 y) override {
+            return derived()->on_jball(joystick_id, ball, x, y);
+        }
+
+        bool jhat(SDL_JoystickID joystick_id, Uint8 hat, Uint8 value) override {
+            return derived()->on_jhat(joystick_id, hat, value);
+        }
+
+        bool jbtndown(SDL_JoystickID joystick_id, Uint8 button) override {
+            return derived()->on_jbtndown(joystick_id, button);
+        }
+
+        bool jbtnup(SDL_JoystickID joystick_id, Uint8 button) override {
+            return derived()->on_jbtnup(joystick_id, button);
+        }
+
+        bool caxis(SDL_JoystickID controller_id, Uint8 axis, Sint16 value) override {
+            return derived()->on_caxis(controller_id, axis, value);
+        }
+
+        bool cbtndown(SDL_JoystickID controller_id, Uint8 button) override {
+            return derived()->on_cbtndown(controller_id, button);
+        }
+
+        bool cbtnup(SDL_JoystickID controller_id, Uint8 button) override {
+            return derived()->on_cbtnup(controller_id, button);
+        }
+
+        bool fingerdown(SDL_TouchID touch_id, SDL_FingerID finger_id, float x, float y,
+                        float pressure) override {
+            return derived()->on_fingerdown(touch_id, finger_id, x, y, pressure);
+        }
+
+        bool fingerup(SDL_TouchID touch_id, SDL_FingerID finger_id, float x, float y,
+                      float pressure) override {
+            return derived()->on_fingerup(touch_id, finger_id, x, y, pressure);
+        }
+
+        bool fingermotion(SDL_TouchID touch_id, SDL_FingerID finger_id, float x, float y, float dx,
+                          float dy, float pressure) override {
+            return derived()->on_fingermotion(touch_id, finger_id, x, y, dx, dy, pressure);
+        }
+
+        bool gesturerecord(SDL_TouchID touch_id, SDL_GestureID gesture_id, Uint32 num_fingers,
+                           float x, float y) override {
+            return derived()->on_gesturerecord(touch_id, gesture_id, num_fingers, x, y);
+        }
+
+        bool gestureperform(SDL_TouchID touch_id, SDL_GestureID gesture_id, Uint32 num_fingers,
+                            float x, float y, float error) override {
+            return derived()->on_gestureperform(touch_id, gesture_id, num_fingers, x, y, error);
+        }
+
+        bool multigesture(SDL_TouchID touch_id, Uint16 num_fingers, float x, float y, float d_theta,
+                          float d_dist) override {
+            return derived()->on_multigesture(touch_id, num_fingers, x, y, d_theta, d_dist);
+        }
+
+        bool userevent(Sint32 code, void *data1, void *data2) override {
+            return derived()->on_userevent(code, data1, data2);
+        }
+    };
+
+    #undef GENEX_HOOK_MASK
+}
+
+#endif // STATICOBJECT_HPP
@@ -0,0 +1,240 @@
+/**
+ * \file thread.cpp
+ *
+ * \author Simon Struthers <snstruthers@gmail.com>
+ * \version pre_dev v0.1.0
+ *
+ * \section LICENSE
+ * GenEx (short for General Executor) - window manager and runtime environment.
+ * Copyright (C) 2019 | The GenEx Project
+ *
+ * This file is part of GenEx.
+ *
+ * GenEx is free software: you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License version 2 as published by the Free Software Foundation.
+ *
+ * GenEx is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at https://www.gnu.org/copyleft/gpl.html
+ *
+ * You should have received a copy of the GNU General Public License version 2 along with GenEx.
+ * If not, see http://www.gnu.org/licenses.
+ *
+ * \section DESCRIPTION
+ * The source file for GenEx threading primitives.
+ *
+ */
+
+#include "thread.hpp"
+
+// --- EVENT RING ---------------------------------------------------------------------------------
+
+namespace {
+    enum RingState { RING_IDLE = 0, RING_SIGNALLED = 1, RING_PARKED = 2 };
+}
+
+GenEx::Thread::EventRing::EventRing(size_t capacity) : head(0), tail(0), state(RING_IDLE) {
+    this->capacity = 1;
+    while (this->capacity < capacity)
+        this->capacity <<= 1;
+    mask = this->capacity - 1;
+
+    buffer = new SDL_Event[this->capacity];
+    wakeup = SDL_CreateSemaphore(0);
+}
+
+GenEx::Thread::EventRing::~EventRing() {
+    SDL_DestroySemaphore(wakeup);
+    delete[] buffer;
+}
+
+bool GenEx::Thread::EventRing::push(const SDL_Event &event) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) >= capacity)
+        return false;
+
+    buffer[t & mask] = event;
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+}
+
+bool GenEx::Thread::EventRing::pop(SDL_Event &event) {
+    size_t h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire))
+        return false;
+
+    event = buffer[h & mask];
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+size_t GenEx::Thread::EventRing::size() const {
+    return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+}
+
+bool GenEx::Thread::EventRing::empty() const { return size() == 0; }
+
+void GenEx::Thread::EventRing::notify() {
+    if (state.exchange(RING_SIGNALLED) == RING_PARKED)
+        SDL_SemPost(wakeup);
+}
+
+bool GenEx::Thread::EventRing::wait(Uint32 timeout) {
+    // a signal arrived while we weren't looking
+    int expected = RING_SIGNALLED;
+    if (state.compare_exchange_strong(expected, RING_IDLE))
+        return true;
+
+    // announce that we're about to sleep; lost the race if a signal slipped in meanwhile
+    expected = RING_IDLE;
+    if (!state.compare_exchange_strong(expected, RING_PARKED)) {
+        state.store(RING_IDLE);
+        return true;
+    }
+
+    int result = (timeout == SDL_MUTEX_MAXWAIT) ? SDL_SemWait(wakeup)
+                                                : SDL_SemWaitTimeout(wakeup, timeout);
+    if (result != 0) {
+        expected = RING_PARKED;
+        if (state.compare_exchange_strong(expected, RING_IDLE))
+            return false;
+
+        // notify() saw us parked & is posting; swallow the post so it doesn't leak into
+        // the next wait
+        SDL_SemWait(wakeup);
+    }
+
+    state.store(RING_IDLE);
+    return true;
+}
+
+// --- JOB POOL -----------------------------------------------------------------------------------
+
+thread_local GenEx::Thread::JobPool *GenEx::Thread::JobPool::current_pool = nullptr;
+thread_local int GenEx::Thread::JobPool::current_index = -1;
+
+GenEx::Thread::JobPool::JobPool(unsigned int num_threads) : stopping(false), next_queue(0),
+                                                            waiting(0) {
+    if (num_threads < 1)
+        num_threads = 1;
+
+    available = SDL_CreateSemaphore(0);
+    for (unsigned int i = 0; i < num_threads; i++) {
+        Worker *worker = new Worker();
+        worker->lock = SDL_CreateMutex();
+        workers.push_back(worker);
+    }
+
+    // reserve up front; worker threads hold pointers into start_data
+    start_data.reserve(num_threads);
+    for (unsigned int i = 0; i < num_threads; i++) {
+        start_data.push_back(StartData{ this, (int)i });
+        std::string name = "genexjob" + std::to_string(i);
+        threads.push_back(SDL_CreateThread(WorkerMain, name.c_str(), &start_data.back()));
+    }
+}
+
+GenEx::Thread::JobPool::~JobPool() {
+    stopping.store(true);
+
+    // other threads may still be inside parallel_for(); finish their chunks so they return
+    while (run_one() || waiting.load() > 0)
+        if (waiting.load() > 0)
+            SDL_Delay(0);
+
+    for (size_t i = 0; i < threads.size(); i++)
+        SDL_SemPost(available);
+    for (auto thread : threads)
+        SDL_WaitThread(thread, nullptr);
+
+    for (auto worker : workers) {
+        SDL_DestroyMutex(worker->lock);
+        delete worker;
+    }
+    SDL_DestroySemaphore(available);
+}
+
+int GenEx::Thread::JobPool::WorkerMain(void *data) {
+    StartData *start = (StartData*)data;
+    JobPool *pool = start->pool;
+
+    current_pool = pool;
+    current_index = start->index;
+
+    while (!pool->stopping.load()) {
+        SDL_SemWait(pool->available);
+        while (!pool->stopping.load() && pool->run_one()) { }
+    }
+    return 0;
+}
+
+size_t GenEx::Thread::JobPool::num_workers() const { return workers.size(); }
+
+void GenEx::Thread::JobPool::submit(GenEx::Thread::JobPool::Job job) {
+    int index = (current_pool == this) ? current_index
+                                       : (int)(next_queue.fetch_add(1) % workers.size());
+
+    Worker *worker = workers[index];
+    SDL_LockMutex(worker->lock);
+    worker->jobs.push_back(std::move(job));
+    SDL_UnlockMutex(worker->lock);
+
+    SDL_SemPost(available);
+}
+
+bool GenEx::Thread::JobPool::take(int index, GenEx::Thread::JobPool::Job &job) {
+    Worker *worker = workers[index];
+    bool found = false;
+
+    SDL_LockMutex(worker->lock);
+    if (!worker->jobs.empty()) {
+        // owners work newest-first to stay cache-warm; thieves take the oldest job
+        if (current_pool == this && index == current_index) {
+            job = std::move(worker->jobs.back());
+            worker->jobs.pop_back();
+        }
+        else {
+            job = std::move(worker->jobs.front());
+            worker->jobs.pop_front();
+        }
+        found = true;
+    }
+    SDL_UnlockMutex(worker->lock);
+
+    return found;
+}
+
+bool GenEx::Thread::JobPool::run_one() {
+    Job job;
+    int own = (current_pool == this) ? current_index : 0;
+
+    for (size_t i = 0; i < workers.size(); i++) {
+        if (take((own + i) % workers.size(), job)) {
+            job();
+            return true;
+        }
+    }
+    return false;
+}
+
+namespace {
+    GenEx::Thread::JobPool *job_pool = nullptr;
+    SDL_SpinLock job_pool_lock = 0;
+}
+
+GenEx::Thread::JobPool &GenEx::Thread::GetJobPool() {
+    SDL_AtomicLock(&job_pool_lock);
+    if (job_pool == nullptr) {
+        int cores = SDL_GetCPUCount();
+        job_pool = new GenEx::Thread::JobPool(cores > 1 ? cores - 1 : 1);
+    }
+    SDL_AtomicUnlock(&job_pool_lock);
+    return *job_pool;
+}
+
+void GenEx::Thread::ShutdownJobPool() {
+    SDL_AtomicLock(&job_pool_lock);
+    delete job_pool;
+    job_pool = nullptr;
+    SDL_AtomicUnlock(&job_pool_lock);
+}
@@ -0,0 +1,258 @@
+/**
+ * \file thread.hpp
+ *
+ * \author Simon Struthers <snstruthers@gmail.com>
+ * \version pre_dev v0.1.0
+ *
+ * \section LICENSE
+ * GenEx (short for General Executor) - window manager and runtime environment.
+ * Copyright (C) 2019 | The GenEx Project
+ *
+ * This file is part of GenEx.
+ *
+ * GenEx is free software: you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License version 2 as published by the Free Software Foundation.
+ *
+ * GenEx is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at https://www.gnu.org/copyleft/gpl.html
+ *
+ * You should have received a copy of the GNU General Public License version 2 along with GenEx.
+ * If not, see http://www.gnu.org/licenses.
+ *
+ * \section DESCRIPTION
+ * The header file for GenEx threading primitives.
+ *
+ */
+
+#ifndef THREAD_HPP
+#define THREAD_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <functional>
+
+#include "base.hpp"
+
+namespace GenEx {
+    namespace Thread {
+
+// --- EVENT RING ---------------------------------------------------------------------------------
+
+        /** \brief The default amount of events an EventRing can hold
+         */
+        const size_t DEFAULT_RING_CAPACITY = 1024;
+
+        /** \brief A bounded single-producer/single-consumer queue of SDL_Events.
+         *
+         * One thread may push() & notify(); one other thread may pop() & wait(). Pushing and
+         * popping never lock or allocate; notify() only touches the semaphore when the consumer
+         * is actually parked inside wait().
+         */
+        class EventRing {
+        private:
+            SDL_Event *buffer;
+            size_t capacity; // always a power of two
+            size_t mask;
+
+            // the padding keeps both sides from fighting over the same cache line
+            char pad0[64];
+            std::atomic<size_t> head; // next slot to read; owned by the consumer
+            char pad1[64];
+            std::atomic<size_t> tail; // next slot to write; owned by the producer
+            char pad2[64];
+
+            std::atomic<int> state; // IDLE, SIGNALLED or PARKED
+            SDL_sem *wakeup;
+
+        public:
+            /** \brief Creates a new ring.
+             *
+             * \param size_t <u><i>capacity</i></u>: How many events the ring can hold; rounded
+             *        up to the next power of two; defaults to <i>DEFAULT_RING_CAPACITY</i>
+             *
+             */
+            EventRing(size_t capacity = DEFAULT_RING_CAPACITY);
+
+            EventRing(const EventRing &other) = delete;
+            EventRing &operator= (const EventRing &other) = delete;
+
+            ~EventRing();
+
+            /** \brief Appends an event to the ring. Producer side only.
+             *
+             * \param SDL_Event &<u>event</u>: The event to append
+             * \return bool FALSE if the ring is full and the event was not appended
+             *
+             */
+            bool push(const SDL_Event &event);
+
+            /** \brief Takes the oldest event out of the ring. Consumer side only.
+             *
+             * \param SDL_Event &<u>event</u>: Where to store the event
+             * \return bool FALSE if the ring was empty
+             *
+             */
+            bool pop(SDL_Event &event);
+
+            /** \brief Returns how many events are currently waiting in the ring.
+             *
+             * \return size_t Number of queued events
+             *
+             */
+            size_t size() const;
+
+            /** \brief Returns whether or not the ring is empty.
+             *
+             * \return bool TRUE if there are no queued events
+             *
+             */
+            bool empty() const;
+
+            /** \brief Signals the consumer that a new batch of events is ready. Wakes it up
+             *        only if it is parked in wait(); otherwise the signal is remembered for
+             *        its next wait(). Producer side only.
+             */
+            void notify();
+
+            /** \brief Parks the consumer until the producer calls notify(). Returns right away
+             *        if a signal is already pending. Consumer side only.
+             *
+             * \param Uint32 <u><i>timeout</i></u>: Maximum time to wait in milliseconds;
+             *        defaults to <i>SDL_MUTEX_MAXWAIT</i> (forever)
+             * \return bool TRUE if signalled; FALSE if the wait timed out
+             *
+             */
+            bool wait(Uint32 timeout = SDL_MUTEX_MAXWAIT);
+        };
+
+// --- JOB POOL -----------------------------------------------------------------------------------
+
+        /** \brief A work-stealing pool of worker threads.
+         *
+         * Every worker owns a queue; it takes jobs from the back of its own queue and, once
+         * that runs dry, steals from the front of the others'. Threads waiting on a batch of
+         * jobs help run them instead of blocking, so jobs may safely submit & wait on more jobs.
+         */
+        class JobPool {
+        public:
+            typedef std::function<void()> Job;
+
+        private:
+            struct Worker {
+                std::deque<Job> jobs;
+                SDL_mutex *lock;
+            };
+
+            struct StartData {
+                JobPool *pool;
+                int index;
+            };
+
+            std::vector<Worker*> workers;
+            std::vector<SDL_Thread*> threads;
+            std::vector<StartData> start_data;
+
+            SDL_sem *available; // posted once per submitted job
+            std::atomic<bool> stopping;
+            std::atomic<unsigned int> next_queue; // round-robin for outside submissions
+            std::atomic<int> waiting; // threads inside parallel_for()
+
+            static thread_local JobPool *current_pool;
+            static thread_local int current_index;
+
+            static int WorkerMain(void *data);
+
+            bool take(int index, Job &job);
+
+        public:
+            /** \brief Starts a new pool.
+             *
+             * \param unsigned int <u>num_threads</u>: How many worker threads to start; at
+             *        least one is always started
+             *
+             */
+            JobPool(unsigned int num_threads);
+
+            JobPool(const JobPool &other) = delete;
+            JobPool &operator= (const JobPool &other) = delete;
+
+            /** \brief Stops the pool once the worker threads have finished their current job.
+             *        Jobs still queued are run on the calling thread first & it waits for every
+             *        thread inside parallel_for() to return, so none is left waiting on chunks
+             *        that would never run.
+             */
+            ~JobPool();
+
+            /** \brief Returns how many worker threads this pool runs.
+             *
+             * \return size_t Number of worker threads
+             *
+             */
+            size_t num_workers() const;
+
+            /** \brief Queues a job. Jobs submitted from a worker go to that worker's own queue.
+             *
+             * \param Job <u>job</u>: The job to run
+             *
+             */
+            void submit(Job job);
+
+            /** \brief Runs one queued job on the calling thread if there is one.
+             *
+             * \return bool FALSE if every queue was empty
+             *
+             */
+            bool run_one();
+
+            /** \brief Splits the range [0, count) into chunks, runs them across the pool and
+             *        returns once every chunk is done. The calling thread helps out.
+             *
+             * \param size_t <u>count</u>: The size of the range
+             * \param size_t <u>grain</u>: The most indices a single chunk covers
+             * \param F <u>fn</u>: Callable taking <i>(size_t begin, size_t end)</i>
+             *
+             */
+            template <typename F>
+            void parallel_for(size_t count, size_t grain, F fn) {
+                if (grain < 1)
+                    grain = 1;
+
+                waiting.fetch_add(1);
+                std::atomic<size_t> remaining((count + grain - 1) / grain);
+                for (size_t begin = grain; begin < count; begin += grain) {
+                    size_t end = std::min(begin + grain, count);
+                    submit([&fn, &remaining, begin, end]() {
+                        fn(begin, end);
+                        remaining.fetch_sub(1);
+                    });
+                }
+
+                // do the first chunk here, then help with the rest
+                if (count > 0) {
+                    fn(0, std::min(grain, count));
+                    remaining.fetch_sub(1);
+                }
+                while (remaining.load() > 0)
+                    if (!run_one())
+                        SDL_Delay(0);
+                waiting.fetch_sub(1);
+            }
+        };
+
+        /** \brief Gets the engine-wide job pool, starting it with one worker per extra CPU
+         *        core on first use.
+         *
+         * \return JobPool& The job pool
+         *
+         */
+        JobPool &GetJobPool();
+
+        /** \brief Stops the engine-wide job pool if it was started.
+         */
+        void ShutdownJobPool();
+    }
+}
+
+#endif // THREAD_HPP
@@ -25,6 +25,8 @@
  *
  */
 
+#include <cmath>
+
 #include "time.hpp"
 
 const double GenEx::Time::GetSecs() {
@@ -36,3 +38,49 @@ const double GenEx::Time::GetTime() {
     return std::chrono::duration_cast<std::chrono::nanoseconds>(
        std::chrono::high_resolution_clock::now() - START_TIME).count() / 1000000000.0;
 }
+
+// --- FRAME SCHEDULER ----------------------------------------------------------------------------
+
+void GenEx::Time::FrameScheduler::discard_stale() {
+    while (!heap.empty()) {
+        auto iter = clients.find(heap.top().id);
+        if (iter != clients.end() && iter->second.generation == heap.top().generation)
+            break;
+        heap.pop();
+    }
+}
+
+void GenEx::Time::FrameScheduler::add(Uint64 id, double framerate, double start) {
+    Client client = { framerate > 0.0 ? 1.0 / framerate : 0.0, next_generation++ };
+    clients[id] = client;
+    heap.push(Deadline{ start, id, client.generation });
+}
+
+void GenEx::Time::FrameScheduler::remove(Uint64 id) { clients.erase(id); }
+
+double GenEx::Time::FrameScheduler::next_deadline() {
+    discard_stale();
+    if (heap.empty())
+        return std::numeric_limits<double>::infinity();
+    return heap.top().time;
+}
+
+bool GenEx::Time::FrameScheduler::pop_due(double now, Uint64 &id) {
+    discard_stale();
+    if (heap.empty() || heap.top().time > now)
+        return false;
+
+    Deadline due = heap.top();
+    heap.pop();
+
+    // keep the cadence steady; only resync if we've fallen more than a whole frame behind
+    double period = clients[due.id].period;
+    due.time += period;
+    if (due.time <= now)
+        due.time = (period > 0.0) ? now + period
+                                  : std::nextafter(now, std::numeric_limits<double>::infinity());
+    heap.push(due);
+
+    id = due.id;
+    return true;
+}
@@ -28,6 +28,10 @@
 #ifndef TIME_HPP
 #define TIME_HPP
 
+#include <queue>
+#include <limits>
+#include <functional>
+
 #include "base.hpp"
 
 namespace GenEx {
@@ -47,6 +51,70 @@ namespace GenEx {
          * \return double Current time in seconds
          */
         const double GetTime();
+
+// --- FRAME SCHEDULER ----------------------------------------------------------------------------
+
+        /** \brief Keeps track of when each of a set of clients (e.g. windows) is next due for a
+         *        frame, ordered in a min-heap by deadline.
+         */
+        class FrameScheduler {
+        private:
+            struct Deadline {
+                double time;
+                Uint64 id;
+                Uint64 generation;
+
+                bool operator> (const Deadline &other) const { return time > other.time; }
+            };
+
+            struct Client {
+                double period; // seconds between frames; 0 for uncapped
+                Uint64 generation;
+            };
+
+            std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline> > heap;
+            std::unordered_map<Uint64, Client> clients;
+            Uint64 next_generation = 0;
+
+            /** \brief Pops heap entries left behind by removed clients.
+             */
+            void discard_stale();
+
+        public:
+            /** \brief Schedules a client.
+             *
+             * \param Uint64 <u>id</u>: The client's ID
+             * \param double <u>framerate</u>: How many frames per second the client wants;
+             *        0 or less for as many as possible
+             * \param double <u>start</u>: When the first frame is due; see <i>GetTime()</i>
+             *
+             */
+            void add(Uint64 id, double framerate, double start);
+
+            /** \brief Unschedules a client; nothing happens if it wasn't scheduled.
+             *
+             * \param Uint64 <u>id</u>: The client's ID
+             *
+             */
+            void remove(Uint64 id);
+
+            /** \brief Returns when the earliest frame is due.
+             *
+             * \return double Time of the earliest deadline (see <i>GetTime()</i>), or infinity
+             *         if nothing is scheduled
+             *
+             */
+            double next_deadline();
+
+            /** \brief Takes one client whose frame is due and schedules its following frame.
+             *
+             * \param double <u>now</u>: The current time; see <i>GetTime()</i>
+             * \param Uint64 &<u>id</u>: Where to store the ID of the due client
+             * \return bool FALSE if no client is due yet
+             *
+             */
+            bool pop_due(double now, Uint64 &id);
+        };
     }
 }
 
@@ -81,6 +81,17 @@ std::vector<std::string> GenEx::Util::Tokenize(std::string s) {
     return ls;
 }
 
+size_t GenEx::Util::SplitTrailingNumber(const std::string &s, Uint64 &number) {
+    size_t start = s.size();
+    while (start > 0 && s.size() - start < 18 && s[start - 1] >= '0' && s[start - 1] <= '9')
+        start--;
+
+    number = 0;
+    for (size_t i = start; i < s.size(); i++)
+        number = number * 10 + (s[i] - '0');
+    return start;
+}
+
 std::vector<std::string> GenEx::Util::RegexSplit(std::string s, std::string regex = "\\s+") {
     std::vector<std::string> elems;
     std::regex rgx(regex);
@@ -66,6 +66,16 @@ namespace GenEx {
          */
         std::vector<std::string> Tokenize(std::string s);
 
+        /** \brief Finds the number at the end of a string, e.g. 12 in "object12".
+         *
+         * \param std::string &<u>s</u>: The string to look at
+         * \param Uint64 &<u>number</u>: Where to store the number; set to 0 if there isn't one
+         * \return size_t Length of the part before the number; <i>s.size()</i> if there isn't
+         *         one. Only the last 18 digits are read, so the number never overflows
+         *
+         */
+        size_t SplitTrailingNumber(const std::string &s, Uint64 &number);
+
 // --- REGEX-RELATED FUNCTIONS --------------------------------------------------------------------
 
         /** \brief Splits a string based on a regular expression (regex).
@@ -131,4 +141,6 @@ namespace GenEx {
     }
 }
 
+#include "util/slotmap.hpp"
+
 #endif // UTIL_HPP
@@ -0,0 +1,203 @@
+/**
+ * \file slotmap.hpp
+ *
+ * \author Simon Struthers <snstruthers@gmail.com>
+ * \version pre_dev v0.1.0
+ *
+ * \section LICENSE
+ * GenEx (short for General Executor) - window manager and runtime environment.
+ * Copyright (C) 2019 | The GenEx Project
+ *
+ * This file is part of GenEx.
+ *
+ * GenEx is free software: you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License version 2 as published by the Free Software Foundation.
+ *
+ * GenEx is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at https://www.gnu.org/copyleft/gpl.html
+ *
+ * You should have received a copy of the GNU General Public License version 2 along with GenEx.
+ * If not, see http://www.gnu.org/licenses.
+ *
+ * \section DESCRIPTION
+ * The header file defining a dense slot map with generational handles.
+ *
+ */
+
+#ifndef UTIL_SLOTMAP_HPP
+#define UTIL_SLOTMAP_HPP
+
+#include "base.hpp"
+
+namespace GenEx {
+    namespace Util {
+
+// --- SLOT HANDLE --------------------------------------------------------------------------------
+
+        /** \brief A reference to a value in a SlotMap. Goes stale once the value is erased,
+         *        even if its slot is reused.
+         */
+        struct SlotHandle {
+            Uint32 index;
+            Uint32 generation;
+
+            bool operator== (const SlotHandle &other) const {
+                return index == other.index && generation == other.generation;
+            }
+            bool operator!= (const SlotHandle &other) const { return !(*this == other); }
+        };
+
+        /** \brief A handle that never refers to anything
+         */
+        const SlotHandle NULL_SLOT_HANDLE = { 0xFFFFFFFF, 0 };
+
+// --- SLOT MAP CLASS -----------------------------------------------------------------------------
+
+        /** \brief A container keeping its values packed in one contiguous array. Values are
+         *        reached through generational handles in O(1); erasing moves the last value
+         *        into the hole, so iteration order is not insertion order.
+         *
+         * \param typename <u>T</u>: The value type
+         *
+         */
+        template <typename T>
+        class SlotMap {
+        private:
+            struct Slot {
+                Uint32 dense_index; // where the value lives; only valid while in use
+                Uint32 generation; // odd while in use, even while free
+            };
+
+            std::vector<T> dense;
+            std::vector<Uint32> dense_slots; // dense index -> slot index
+            std::vector<Slot> slots;
+            std::vector<Uint32> free_slots;
+
+        public:
+            typedef typename std::vector<T>::iterator iterator;
+            typedef typename std::vector<T>::const_iterator const_iterator;
+
+            /** \brief Adds a value.
+             *
+             * \param T <u>value</u>: The value to add
+             * \return SlotHandle Handle to the new value
+             *
+             */
+            SlotHandle insert(T value) {
+                Uint32 index;
+                if (!free_slots.empty()) {
+                    index = free_slots.back();
+                    free_slots.pop_back();
+                }
+                else {
+                    index = slots.size();
+                    slots.push_back(Slot{ 0, 0 });
+                }
+
+                Slot &slot = slots[index];
+                slot.dense_index = dense.size();
+                slot.generation++;
+
+                dense.push_back(std::move(value));
+                dense_slots.push_back(index);
+                return SlotHandle{ index, slot.generation };
+            }
+
+            /** \brief Returns whether or not a handle still refers to a value.
+             *
+             * \param SlotHandle <u>handle</u>: A handle
+             * \return bool TRUE if the value hasn't been erased
+             *
+             */
+            bool contains(SlotHandle handle) const {
+                return handle.index < slots.size() &&
+                       slots[handle.index].generation == handle.generation &&
+                       (handle.generation & 1);
+            }
+
+            /** \brief Gets the value a handle refers to.
+             *
+             * \param SlotHandle <u>handle</u>: A handle
+             * \return T* Pointer to the value, or NULLPTR if the handle is stale
+             *
+             */
+            T *get(SlotHandle handle) {
+                return contains(handle) ? &dense[slots[handle.index].dense_index] : nullptr;
+            }
+
+            /** \brief Gets the handle of the value at a position in the packed array.
+             *
+             * \param size_t <u>dense_index</u>: Position in the array; less than size()
+             * \return SlotHandle Handle to the value
+             *
+             */
+            SlotHandle handle_at(size_t dense_index) const {
+                Uint32 index = dense_slots[dense_index];
+                return SlotHandle{ index, slots[index].generation };
+            }
+
+            /** \brief Erases the value a handle refers to by moving the last value into its
+             *        place.
+             *
+             * \param SlotHandle <u>handle</u>: A handle
+             * \return bool FALSE if the handle was already stale
+             *
+             */
+            bool erase(SlotHandle handle) {
+                if (!contains(handle))
+                    return false;
+
+                Uint32 hole = slots[handle.index].dense_index;
+                Uint32 last = dense.size() - 1;
+                if (hole != last) {
+                    dense[hole] = std::move(dense[last]);
+                    dense_slots[hole] = dense_slots[last];
+                    slots[dense_slots[hole]].dense_index = hole;
+                }
+                dense.pop_back();
+                dense_slots.pop_back();
+
+                slots[handle.index].generation++;
+                free_slots.push_back(handle.index);
+                return true;
+            }
+
+            /** \brief Erases every value. Every existing handle goes stale.
+             */
+            void clear() {
+                for (Uint32 index : dense_slots) {
+                    slots[index].generation++;
+                    free_slots.push_back(index);
+                }
+                dense.clear();
+                dense_slots.clear();
+            }
+
+            /** \brief Reserves room for a number of values.
+             *
+             * \param size_t <u>count</u>: How many values to make room for
+             *
+             */
+            void reserve(size_t count) {
+                dense.reserve(count);
+                dense_slots.reserve(count);
+            }
+
+            size_t size() const { return dense.size(); }
+            bool empty() const { return dense.empty(); }
+
+            T &operator[] (size_t dense_index) { return dense[dense_index]; }
+            const T &operator[] (size_t dense_index) const { return dense[dense_index]; }
+
+            iterator begin() { return dense.begin(); }
+            iterator end() { return dense.end(); }
+            const_iterator begin() const { return dense.cbegin(); }
+            const_iterator end() const { return dense.cend(); }
+            const_iterator cbegin() const { return dense.cbegin(); }
+            const_iterator cend() const { return dense.cend(); }
+        };
+    }
+}
+
+#endif // UTIL_SLOTMAP_HPP